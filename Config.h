@@ -31,6 +31,64 @@ ofstream logFile("Results/Logs.csv", ios::app);
 // dataset path
 string datasetPath = "Datasets/";
 
+// number of threads for parallel tasks, 0 means using all hardware threads
+unsigned int threadNum = 0;
+
+// answer queries of each query set by threadNum threads in parallel, with work stealing
+bool parallelQueries = false;
+
+// compare the scalar query loop with the interleaved query pipeline of different group sizes, for graphs with small number of labels
+bool interleavedQueries = false;
+
+// merge parallel edges between the same pair of vertices into one entry with a label set, when |L|<=32
+bool collapseParallelEdges = false;
+
+// relabel vertices after loading graph to improve locality, "rcm", "degree", "hop", or "" for not relabeling
+string reorderStrategy = "";
+
+// use bidirectional label constrained BFS for query generation and BFS fallback of IndexL
+bool bidirectionalSearch = false;
+
+// direction-optimizing label constrained BFS, switching to bottom-up steps when the frontier is large
+bool directionOptimizing = false;
+
+// check answers in query files by multi-source BFS after running queries
+bool verifyQueries = false;
+
+// index file, loaded via mmap if it matches the graph, otherwise the index is built and saved to it, "" for always building
+string indexFilename = "";
+
+// store 2-hop index in compressed form (grouped hop ids, delta and varint coded, bit-packed label sets), decoded on the fly by queries
+bool compressIndex = false;
+
+// hop order for building 2-hop index, "degree", "product", "label-degree", "betweenness", "scc", or "file" for
+// reading the order from hopOrderFilename (one raw vertex id per line, from the highest ranked hop)
+string hopOrderStrategy = "degree";
+string hopOrderFilename = "";
+
+// skip (vertex, label set) pairs dominated by pairs visited in the same level of pruned BFS before pruning checks,
+// which pays off when vertices are reached many times per level, e.g., dense graphs with few labels
+bool dedupFrontiers = false;
+
+// maximum number of labels in label sets of 2-hop index entries, where label sets are not expanded further, and
+// queries with more labels are answered by search if the index does not find a path, 0 for no limit
+unsigned int labelBudget = 0;
+
+// remove entries implied by other entries after building 2-hop index, e.g., entries kept since hops of the same
+// batch do not prune each other when building by several threads
+bool removeRedundant = false;
+
+// file of terminals (one raw vertex id per line), where only ends of DOR chains of terminals keep hop lists, so that
+// queries between terminals are answered by the index, and other queries fall back to search, "" for all vertices
+string terminalFilename = "";
+
+// edges (one "src dst label" per line) inserted into the index after running queries, "" for no insertions
+string insertEdgesFilename = "";
+
+// instead of updating the index incrementally, insert edges into a new index version rebuilt in background,
+// while the current version keeps answering queries
+bool backgroundRebuild = false;
+
 // Merge all secondary labels into THRESHOLD virtual labels, when |L|>2*THRESHOLD
 #define THRESHOLD 6
 
@@ -0,0 +1,92 @@
+/*
+LCR - Benchmark Intersection of Hop Lists
+Author: Yuzheng Cai
+2022-10-27
+------------------------------
+C++ 11 
+Compare hop list intersection kernels on random sorted hop lists of different size ratios
+*/
+
+
+#include "../../Index/HopIntersection.cc"
+#include <random>
+
+
+// random hop list sorted by hop id, where some hops have several entries with different label sets
+vector<HopEntry> randomHopList(mt19937& rng, size_t len, VertexID maxHopId, int labelNum) {
+    vector<HopEntry> hops;
+    uniform_int_distribution<VertexID> hopDist(0, maxHopId);
+    uniform_int_distribution<int> labelDist(0, labelNum-1), dupDist(0, 7);
+    while (hops.size()<len) {
+        VertexID hopId = hopDist(rng);
+        int entryNum = dupDist(rng)==0 ? 2 : 1;
+        for (int i=0; i<entryNum; ++i)
+            hops.push_back(make_pair(hopId, (LabelSet)1<<labelDist(rng) | (LabelSet)1<<labelDist(rng)));
+    }
+    sort(hops.begin(), hops.end());
+    return hops;
+}
+
+
+int main(int argc, char *argv[]) {
+
+    if ( argc > 1 && string(argv[1])=="-h" ) {
+        cout << "./BenchIntersect [short list length] [number of pairs]" << endl;
+        return 1;
+    }
+
+    size_t shortLen = argc>1 ? atoi(argv[1]) : 64;
+    size_t pairNum = argc>2 ? atoi(argv[2]) : 20000;
+    const int labelNum = 8, rounds = 5;
+    mt19937 rng(2022);
+    printf("- Dispatched kernel: %s, short list length: %zu, number of pairs: %zu\n", intersectHopsKernelName, shortLen, pairNum);
+
+    const string names[5] = {"scalar", "sse4.1", "avx2", "gallop", "dispatch"};
+    const HopIntersectFunc kernels[4] = {intersectHopsScalar, intersectHopsSSE, intersectHopsAVX2, intersectHopsGallop};
+    const bool supported[5] = {true, __builtin_cpu_supports("sse4.1")!=0, __builtin_cpu_supports("avx2")!=0, true, true};
+    const int ratios[5] = {1, 4, 16, 64, 256};
+    for (int r=0; r<5; ++r) {
+
+        // hop ids are drawn from a large universe, so that most pairs share no usable hop and lists are fully scanned
+        size_t longLen = shortLen*ratios[r];
+        VertexID maxHopId = (VertexID)(shortLen*longLen*4);
+        vector<vector<HopEntry>> as, bs;
+        vector<LabelSet> lss;
+        for (size_t i=0; i<pairNum; ++i) {
+            as.push_back(randomHopList(rng, shortLen, maxHopId, labelNum));
+            bs.push_back(randomHopList(rng, longLen, maxHopId, labelNum));
+            lss.push_back((LabelSet)rng() & ((1<<labelNum)-1));
+        }
+
+        printf("- Ratio 1:%d\n", ratios[r]);
+        double baseTime = 0;
+        vector<bool> baseAnswers;
+        for (int k=0; k<5; ++k) {
+            if (supported[k]==false) {
+                printf("  %-8s: not supported by CPU\n", names[k].c_str());
+                continue;
+            }
+            vector<bool> answers(pairNum);
+            double timeCost = 1e18;
+            for (int round=0; round<rounds; ++round) {
+                startRecordWallTime();
+                for (size_t i=0; i<pairNum; ++i)
+                    answers[i] = k<4 ? kernels[k](as[i].data(), as[i].data()+as[i].size(), bs[i].data(), bs[i].data()+bs[i].size(), lss[i])
+                                     : intersectHops(as[i], bs[i], lss[i]);
+                timeCost = min(timeCost, getElapsedWallTimeInMs());
+            }
+            if (k==0) {
+                baseTime = timeCost;
+                baseAnswers = answers;
+            }
+
+            int errorCnt = 0, trueCnt = 0;
+            for (size_t i=0; i<pairNum; ++i) {
+                errorCnt += answers[i]!=baseAnswers[i];
+                trueCnt += answers[i];
+            }
+            printf("  %-8s: %.2fms, speedup: %.2fx, true answers: %d, disagreements with scalar: %d\n", names[k].c_str(), timeCost, baseTime/timeCost, trueCnt, errorCnt);
+        }
+    }
+    return 0;
+}
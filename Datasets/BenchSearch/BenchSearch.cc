@@ -0,0 +1,74 @@
+/*
+LCR - Benchmark Online Label Constrained Search
+Author: Yuzheng Cai
+2022-09-08
+------------------------------
+C++ 11 
+Compare top-down BFS with other online search strategies on the same query file
+*/
+
+
+#include "../../GraphUtils/Graph.cc"
+
+
+// run all queries by one search strategy, return wall time in ms
+double runSearch(Graph* graph, const vector<PerQuery>& queries, bool largeLabelSet, int strategy, vector<bool>& answers) {
+    answers.assign(queries.size(), false);
+    startRecordWallTime();
+    for (size_t i=0; i<queries.size(); ++i) {
+        const PerQuery& q = queries[i];
+        if (strategy==0)
+            answers[i] = largeLabelSet ? graph->LCRsearch(q.s, q.t, q.lls) : graph->LCRsearch(q.s, q.t, q.ls);
+        else if (strategy==1)
+            answers[i] = largeLabelSet ? graph->doLCRsearch(q.s, q.t, q.lls) : graph->doLCRsearch(q.s, q.t, q.ls);
+        else 
+            answers[i] = largeLabelSet ? graph->biLCRsearch(q.s, q.t, q.lls) : graph->biLCRsearch(q.s, q.t, q.ls);
+    }
+    return getElapsedWallTimeInMs();
+}
+
+
+int main(int argc, char *argv[]) {
+
+    if ( argc < 3 ) {
+        cout << "./BenchSearch <edge file> <query file> [-collapse]" << endl;
+        return 1;
+    }
+
+    string graphFilename = argv[1];
+    string queryFilename = argv[2];
+    if (argc>3 && string(argv[3])=="-collapse")
+        collapseParallelEdges = true;
+
+    // read in graph and queries
+    Graph* graph = new Graph(graphFilename);
+    graph->initializeLCRsearch();
+    bool largeLabelSet = graph->labelNum > 2*THRESHOLD;
+    vector<PerQuery> queries = loadQueryFile(queryFilename, largeLabelSet);
+
+    // each strategy is compared with top-down BFS
+    const string names[4] = {"top-down", "direction-optimizing", "bidirectional", "multi-source batch"};
+    double baseTime = 0;
+    for (int strategy=0; strategy<4; ++strategy) {
+        vector<bool> answers;
+        double timeCost;
+        if (strategy<3)
+            timeCost = runSearch(graph, queries, largeLabelSet, strategy, answers);
+        else {
+            startRecordWallTime();
+            graph->LCRsearchBatch(queries, largeLabelSet, answers);
+            timeCost = getElapsedWallTimeInMs();
+        }
+        if (strategy==0)
+            baseTime = timeCost;
+
+        int errorCnt = 0;
+        for (size_t i=0; i<queries.size(); ++i)
+            if (answers[i]!=queries[i].ans)
+                ++errorCnt;
+        printf("- %s: %.2fms, speedup: %.2fx, wrong answers: %d\n", names[strategy].c_str(), timeCost, baseTime/timeCost, errorCnt);
+    }
+
+    delete graph;
+    return 0;
+}
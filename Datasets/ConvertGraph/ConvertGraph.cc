@@ -0,0 +1,35 @@
+/*
+LCR - Convert Graph into Binary Format
+Author: Yuzheng Cai
+2022-09-08
+------------------------------
+C++ 11 
+The binary graph can be mapped into memory directly, without parsing the txt file
+*/
+
+
+#include "../../GraphUtils/Graph.cc"
+
+
+int main(int argc, char *argv[]) {
+
+    if ( argc < 2 ) {
+        cout << "./ConvertGraph <edge file> [<binary file>, default: <edge file>.bin]" << endl;
+        return 1;
+    }
+
+    string graphFilename = argv[1];
+    string binaryFilename = argc>2 ? argv[2] : graphFilename+".bin";
+
+    // read in graph
+    Graph* graph = new Graph(graphFilename);
+
+    // dump in binary format
+    cout << "Writing binary graph " << binaryFilename << " ..." << endl;
+    startRecordTime();
+    graph->writeBinary(binaryFilename);
+    printf("- Finished. Time cost: %.0fms\n", getElapsedTimeInMs());
+
+    delete graph;
+    return 0;
+}
@@ -10,6 +10,7 @@ Implementations based on https://github.com/khaledammar/LCR
 
 #include "../../GraphUtils/Graph.cc"
 bool largeLabelSet = false;
+bool batchSearch = false;
 
 
 // Generates random labelset with exactly nK labels randomly, for small label set
@@ -66,17 +67,26 @@ void generatePerQuerySet(int numOfQueriesPerQuerySet, vector<PerQuery>& querySet
         if (largeLabelSet) {
             vector<LabelID> lls;
             lls = generateLabelSet(lls, numOfLabel, labelDistribution, labelGenerator);
-            if( graph->LCRsearch(s, t, lls) ) 
-                querySet.emplace_back(s, t, lls, true);
-            else 
-                querySet.emplace_back(s, t, lls, false);
+            querySet.emplace_back(s, t, lls, false);
         } else {
             LabelSet ls = 0;
             ls = generateLabelSet(ls, numOfLabel, labelDistribution, labelGenerator);
-            if( graph->LCRsearch(s, t, ls) ) 
-                querySet.emplace_back(s, t, ls, true);
-            else 
-                querySet.emplace_back(s, t, ls, false);
+            querySet.emplace_back(s, t, ls, false);
+        }
+    }
+
+    // compute answers, either in batches via multi-source BFS, or one by one
+    if (batchSearch) {
+        vector<bool> answers;
+        graph->LCRsearchBatch(querySet, largeLabelSet, answers);
+        for (size_t i=0; i<querySet.size(); ++i)
+            querySet[i].ans = answers[i];
+    } else {
+        for (PerQuery& q : querySet) {
+            if (largeLabelSet)
+                q.ans = bidirectionalSearch ? graph->biLCRsearch(q.s, q.t, q.lls) : graph->LCRsearch(q.s, q.t, q.lls);
+            else
+                q.ans = bidirectionalSearch ? graph->biLCRsearch(q.s, q.t, q.ls) : graph->LCRsearch(q.s, q.t, q.ls);
         }
     }
     cout << "- Finished"<<endl;
@@ -104,7 +114,7 @@ void writeQuerySetToFile(vector<PerQuery>& querySet, string queryFilename) {
 int main(int argc, char *argv[]) {
 
     if ( argc < 3 ) {
-        cout << "./GenQuery <edge file> <k: number of query sets> <l: number of queries> <k numbers denoting number of labels per query>"  << endl;
+        cout << "./GenQuery <edge file> <k: number of query sets> <l: number of queries> <k numbers denoting number of labels per query> [-bidirectional] [-direction-optimizing] [-batch]"  << endl;
         return 1;
     }
 
@@ -115,7 +125,7 @@ int main(int argc, char *argv[]) {
 
     if ( argc < (3+numOfQuerySet) ) {
         cout << "Too few label numbers !" << endl;
-        cout << "./GenQuery <edge file> <k: number of query sets> <l: number of queries> <k numbers denoting number of labels per query>" << endl;
+        cout << "./GenQuery <edge file> <k: number of query sets> <l: number of queries> <k numbers denoting number of labels per query> [-bidirectional] [-direction-optimizing] [-batch]" << endl;
         return 1;
     }
 
@@ -124,9 +134,27 @@ int main(int argc, char *argv[]) {
         numOfLabels.push_back( numOfLabel );
     }
 
+    // options
+    for (int i = 4+numOfQuerySet; i < argc; ++i) {
+        string option = argv[i];
+        if (option=="-bidirectional")
+            bidirectionalSearch = true;
+        else if (option=="-direction-optimizing")
+            directionOptimizing = true;
+        else if (option=="-batch")
+            batchSearch = true;
+        else {
+            cout << "! Unknown option " << option << endl;
+            return 1;
+        }
+    }
+
     cout << "# graph filename: " << graphFilename << endl;
     cout << "# num of query sets: " << numOfQuerySet << endl;
     cout << "# num of queries per query set: " << numOfQueriesPerQuerySet << endl;
+    cout << "# bidirectional search: " << (bidirectionalSearch?"yes":"no") << endl;
+    cout << "# direction-optimizing search: " << (directionOptimizing?"yes":"no") << endl;
+    cout << "# batch search: " << (batchSearch?"yes":"no") << endl;
 
     // initialize graph data
     Graph* graph = new Graph(graphFilename);
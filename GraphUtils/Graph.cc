@@ -12,33 +12,270 @@ C++ 11
 #include "Graph.h"
 
 
-// function for reading the input txt file
+// function for reading the input graph file
 Graph::Graph(const string& filename) {
 
-    // for recording time cost
-    startRecordTime();
+    // for recording time cost, graph loading runs on multiple threads
+    startRecordWallTime();
     cout<<"Start reading in "<<filename<<" ..."<<endl;
 
-    VertexID i, fromId, toId;
-	LabelID label;
+    // binary graph files are mapped into memory directly, otherwise parse the txt file
+    if (!loadBinary(filename))
+        loadText(filename);
+    if (reorderStrategy!="")
+        reorder(reorderStrategy);
+    if (collapseParallelEdges)
+        collapse();
+
+    // for recording time cost
+    double elapsedTime = getElapsedWallTimeInMs();
+    printf("- Finshed, |V|=%d, |E|=%d, |L|=%d, d=%.1f. Time cost: %.0fms\n", VN, EN, labelNum, float(EN)/VN, elapsedTime);
+    printf("- Graph size: %.0f bytes, %d out-label runs, %d in-label runs\n", getGraphSizeInBytes(), out.runN, in.runN);
+    if (reordered)
+        printf("- Relabeled vertices in %s order\n", reorderStrategy.c_str());
+    if (collapsed)
+        printf("- Collapsed parallel edges into %d entries, average multiplicity=%.2f\n", maskedEN, float(adjEN)/max(maskedEN, 1));
+}
+
+
+Graph::~Graph() {
+    if (mappedFile)
+        munmap(mappedFile, mappedSize);
+    else {
+        CSRneighbors* adjs[2] = {&out, &in};
+        for (CSRneighbors* adj : adjs) {
+            delete[] adj->offsets;
+            delete[] adj->ids;
+            delete[] adj->runOffsets;
+            delete[] adj->runLabels;
+            delete[] adj->runStarts;
+        }
+    }
+    if (reordered) {
+        delete[] raw2new;
+        delete[] new2raw;
+    }
+    if (collapsed) {
+        MaskedNeighbors* adjs[2] = {&maskedOut, &maskedIn};
+        for (MaskedNeighbors* adj : adjs) {
+            delete[] adj->offsets;
+            delete[] adj->ids;
+            delete[] adj->masks;
+        }
+    }
+    if (defaultContext)
+        delete defaultContext;
+}
+
+
+// edges parsed by one thread from a chunk of the txt file
+struct EdgeBuffer {
+    vector<VertexID> fromIds, toIds;
+    vector<LabelID> labels;
+};
+
+
+// parse an unsigned integer starting from p, without locale, return the position after it
+static inline const char* parseUnsigned(const char* p, const char* end, unsigned int& x) {
+    while (p<end && (*p<'0' || *p>'9'))
+        ++p;
+    x = 0;
+    while (p<end && *p>='0' && *p<='9')
+        x = x*10 + (*p++-'0');
+    return p;
+}
+
+
+// fill CSR neighbors from per-thread edge buffers, neighbors of each vertex are sorted by (label, neighbor id)
+static void buildCSR(CSRneighbors& adj, const VertexID& VN, const EdgeID& edgeCnt, const vector<EdgeBuffer>& buffers, bool reversed, const unsigned int& num) {
+    adj.offsets = new EdgeID[VN+1]();
+    adj.ids = new VertexID[edgeCnt];
+    LabelID* labels = new LabelID[edgeCnt];         // label of each edge, only used for building label runs
+
+    // counting pass, self-loops are skipped
+    runInParallel(num, [&](unsigned int tid) {
+        const EdgeBuffer& buffer = buffers[tid];
+        const vector<VertexID>& fromIds = reversed ? buffer.toIds : buffer.fromIds;
+        for (size_t i=0; i<fromIds.size(); ++i)
+            if (buffer.fromIds[i]!=buffer.toIds[i])
+                __sync_fetch_and_add(&adj.offsets[fromIds[i]+1], 1);
+    });
+    for (VertexID v=0; v<VN; ++v)
+        adj.offsets[v+1] += adj.offsets[v];
+
+    // scatter edges, using pos[v] as the insert position of v
+    EdgeID* pos = new EdgeID[VN];
+    memcpy(pos, adj.offsets, sizeof(EdgeID)*VN);
+    runInParallel(num, [&](unsigned int tid) {
+        const EdgeBuffer& buffer = buffers[tid];
+        const vector<VertexID>& fromIds = reversed ? buffer.toIds : buffer.fromIds;
+        const vector<VertexID>& toIds = reversed ? buffer.fromIds : buffer.toIds;
+        for (size_t i=0; i<fromIds.size(); ++i)
+            if (fromIds[i]!=toIds[i]) {
+                EdgeID p = __sync_fetch_and_add(&pos[fromIds[i]], 1);
+                adj.ids[p] = toIds[i];
+                labels[p] = buffer.labels[i];
+            }
+    });
+    delete[] pos;
+
+    // sort neighbors of each vertex by (label, neighbor id) and count label runs, vertices are interleaved among threads
+    adj.runOffsets = new EdgeID[VN+1]();
+    runInParallel(num, [&](unsigned int tid) {
+        vector<pair<LabelID, VertexID>> tmp;
+        for (VertexID v=tid; v<VN; v+=num) {
+            tmp.clear();
+            for (EdgeID e=adj.offsets[v]; e<adj.offsets[v+1]; ++e)
+                tmp.emplace_back(labels[e], adj.ids[e]);
+            sort(tmp.begin(), tmp.end());
+            for (EdgeID e=adj.offsets[v], j=0; e<adj.offsets[v+1]; ++e, ++j) {
+                labels[e] = tmp[j].first;
+                adj.ids[e] = tmp[j].second;
+                if (j==0 || tmp[j].first!=tmp[j-1].first)
+                    ++adj.runOffsets[v+1];
+            }
+        }
+    });
+    for (VertexID v=0; v<VN; ++v)
+        adj.runOffsets[v+1] += adj.runOffsets[v];
+
+    // build label runs
+    adj.runN = adj.runOffsets[VN];
+    adj.runLabels = new LabelID[adj.runN];
+    adj.runStarts = new EdgeID[adj.runN+1];
+    adj.runStarts[adj.runN] = edgeCnt;
+    runInParallel(num, [&](unsigned int tid) {
+        for (VertexID v=tid; v<VN; v+=num) {
+            EdgeID r = adj.runOffsets[v];
+            for (EdgeID e=adj.offsets[v]; e<adj.offsets[v+1]; ++e)
+                if (e==adj.offsets[v] || labels[e]!=labels[e-1]) {
+                    adj.runLabels[r] = labels[e];
+                    adj.runStarts[r] = e;
+                    ++r;
+                }
+        }
+    });
+    delete[] labels;
+}
+
+
+// read in the input txt file, chunks of the file are parsed by multiple threads
+void Graph::loadText(const string& filename) {
+
+    // map the txt file into memory
+    int fd = open(filename.c_str(), O_RDONLY);
+    struct stat fileStat;
+    if (fd<0 || fstat(fd, &fileStat)!=0) {
+        cerr<<"! Error! Cannot open "<<filename<<endl;
+        exit(-1);
+    }
+    size_t fileSize = fileStat.st_size;
+    const char* data = fileSize ? (const char*)mmap(NULL, fileSize, PROT_READ, MAP_PRIVATE, fd, 0) : NULL;
+    close(fd);
+    if (data==MAP_FAILED) {
+        cerr<<"! Error! Cannot map "<<filename<<" into memory!"<<endl;
+        exit(-1);
+    }
+    const char* end = data+fileSize;
 
     // read in the vertex number and edge number of the input graph
-    ifstream inputfile(filename);
-    inputfile>>VN>>EN>>labelNum;
+    const char* body = parseUnsigned(data, end, VN);
+    body = parseUnsigned(body, end, EN);
+    body = parseUnsigned(body, end, labelNum);
+    while (body<end && *body!='\n')
+        ++body;
 
-    // allocate space and read in input graph
-    neighbors = new PerNeighbor[VN]();
+    // split into chunks at newline boundaries
+    unsigned int num = getThreadNum();
+    vector<const char*> chunkBegin(num+1);
+    for (unsigned int i=0; i<num; ++i) {
+        const char* p = body + (end-body)*i/num;
+        while (p>body && p<end && *(p-1)!='\n')
+            ++p;
+        chunkBegin[i] = p;
+    }
+    chunkBegin[num] = end;
 
-    // read in each edge
-    for (i=0; i<EN; ++i) { 
-        inputfile>>fromId>>toId>>label;
-        if (fromId!=toId) {        // do not consider edges that link to itself
-            neighbors[fromId].out[label].emplace_back(toId);
-            neighbors[fromId].outDegree++;
-            neighbors[toId].in[label].emplace_back(fromId);
-            neighbors[toId].inDegree++;
+    // parse each chunk, all edges including self-loops are kept for counting lines
+    vector<EdgeBuffer> buffers(num);
+    runInParallel(num, [&](unsigned int tid) {
+        EdgeBuffer& buffer = buffers[tid];
+        const char *p = chunkBegin[tid], *chunkEnd = chunkBegin[tid+1];
+        VertexID fromId, toId;
+        LabelID label;
+        buffer.fromIds.reserve((chunkEnd-p)/6);
+        buffer.toIds.reserve((chunkEnd-p)/6);
+        buffer.labels.reserve((chunkEnd-p)/6);
+        while (true) {
+            while (p<chunkEnd && (*p<'0' || *p>'9'))
+                ++p;
+            if (p==chunkEnd)
+                break;
+            p = parseUnsigned(p, chunkEnd, fromId);
+            p = parseUnsigned(p, chunkEnd, toId);
+            p = parseUnsigned(p, chunkEnd, label);
+            buffer.fromIds.emplace_back(fromId);
+            buffer.toIds.emplace_back(toId);
+            buffer.labels.emplace_back(label);
         }
-        labels.insert(label);
+    });
+    munmap((void*)data, fileSize);
+
+    // only the first EN edges are considered
+    EdgeID totalCnt = 0;
+    for (EdgeBuffer& buffer : buffers) {
+        totalCnt += buffer.fromIds.size();
+        if (totalCnt > EN) {
+            EdgeID keep = buffer.fromIds.size()-(totalCnt-EN);
+            buffer.fromIds.resize(keep);
+            buffer.toIds.resize(keep);
+            buffer.labels.resize(keep);
+            totalCnt = EN;
+        }
+    }
+    if (totalCnt < EN) {
+        cerr<<"! Error! The graph should have "<<EN<<" edges, but only "<<totalCnt<<" edges are found!"<<endl;
+        exit(-1);
+    }
+
+    // collect the labels and count edges that do not link to itself, and find vertex IDs out of range
+    // labels no less than EN must be illegal, and they are kept separately to bound the memory
+    vector<vector<bool>> threadLabels(num);
+    vector<unordered_set<LabelID>> threadIllegalLabels(num);
+    vector<EdgeID> threadEdgeCnt(num, 0);
+    vector<long long> threadIllegalId(num, -1);
+    runInParallel(num, [&](unsigned int tid) {
+        const EdgeBuffer& buffer = buffers[tid];
+        vector<bool>& seen = threadLabels[tid];
+        for (size_t i=0; i<buffer.labels.size(); ++i) {
+            if (buffer.fromIds[i]>=VN || buffer.toIds[i]>=VN) {
+                threadIllegalId[tid] = max(buffer.fromIds[i], buffer.toIds[i]);
+                break;
+            }
+            const LabelID& label = buffer.labels[i];
+            if (label>=EN)
+                threadIllegalLabels[tid].insert(label);
+            else {
+                if (label>=seen.size())
+                    seen.resize(label+1, false);
+                seen[label] = true;
+            }
+            if (buffer.fromIds[i]!=buffer.toIds[i])
+                ++threadEdgeCnt[tid];
+        }
+    });
+    for (unsigned int tid=0; tid<num; ++tid)
+        if (threadIllegalId[tid]>=0) {
+            cerr<<"! Error! The graph has "<<VN<<" vertices, and vertex ID "<<threadIllegalId[tid]<<" is illegal!"<<endl;
+            exit(-1);
+        }
+    adjEN = 0;
+    for (unsigned int tid=0; tid<num; ++tid) {
+        adjEN += threadEdgeCnt[tid];
+        for (LabelID label=0; label<threadLabels[tid].size(); ++label)
+            if (threadLabels[tid][label])
+                labels.insert(label);
+        labels.insert(threadIllegalLabels[tid].begin(), threadIllegalLabels[tid].end());
     }
 
     // check the labels
@@ -49,103 +286,1075 @@ Graph::Graph(const string& filename) {
             exit(-1);
         }
 
-    // for recording time cost
-    double elapsedTime = getElapsedTimeInMs();
-    printf("- Finshed, |V|=%d, |E|=%d, |L|=%d, d=%.1f. Time cost: %.0fms\n", VN, EN, labelNum, float(EN)/VN, elapsedTime);
+    // build out- and in-neighbors
+    buildCSR(out, VN, adjEN, buffers, false, num);
+    buildCSR(in, VN, adjEN, buffers, true, num);
 }
 
 
-Graph::~Graph() {
-    delete[] neighbors;
-    if (initialized) {
-        delete[] visited;
-        delete[] Q;
+// merge all edges between the same pair of vertices into one entry with a label set
+static void buildMasked(MaskedNeighbors& masked, const CSRneighbors& adj, const VertexID& VN, const unsigned int& num) {
+    masked.offsets = new EdgeID[VN+1]();
+
+    // gather (neighbor id, label set) of each vertex, vertices are interleaved among threads
+    auto gather = [&](const VertexID& v, vector<pair<VertexID, LabelSet>>& tmp) {
+        tmp.clear();
+        for (EdgeID r=adj.runOffsets[v]; r<adj.runOffsets[v+1]; ++r)
+            for (EdgeID e=adj.runStarts[r]; e<adj.runStarts[r+1]; ++e)
+                tmp.emplace_back(adj.ids[e], 1<<adj.runLabels[r]);
+        sort(tmp.begin(), tmp.end());
+        size_t cnt = 0;
+        for (size_t j=0; j<tmp.size(); ++j)
+            if (cnt>0 && tmp[cnt-1].first==tmp[j].first)
+                tmp[cnt-1].second |= tmp[j].second;
+            else
+                tmp[cnt++] = tmp[j];
+        tmp.resize(cnt);
+    };
+
+    // counting pass
+    runInParallel(num, [&](unsigned int tid) {
+        vector<pair<VertexID, LabelSet>> tmp;
+        for (VertexID v=tid; v<VN; v+=num) {
+            gather(v, tmp);
+            masked.offsets[v+1] = tmp.size();
+        }
+    });
+    for (VertexID v=0; v<VN; ++v)
+        masked.offsets[v+1] += masked.offsets[v];
+
+    // fill entries
+    masked.ids = new VertexID[masked.offsets[VN]];
+    masked.masks = new LabelSet[masked.offsets[VN]];
+    runInParallel(num, [&](unsigned int tid) {
+        vector<pair<VertexID, LabelSet>> tmp;
+        for (VertexID v=tid; v<VN; v+=num) {
+            gather(v, tmp);
+            for (EdgeID e=masked.offsets[v], j=0; e<masked.offsets[v+1]; ++e, ++j) {
+                masked.ids[e] = tmp[j].first;
+                masked.masks[e] = tmp[j].second;
+            }
+        }
+    });
+}
+
+
+// collapse parallel edges, only for graphs whose labels fit in a label set
+void Graph::collapse() {
+    if (labelNum > 8*sizeof(LabelSet)) {
+        cout<<"- Parallel edges are not collapsed, since |L|="<<labelNum<<" exceeds the size of label set"<<endl;
+        return;
     }
+    unsigned int num = getThreadNum();
+    buildMasked(maskedOut, out, VN, num);
+    buildMasked(maskedIn, in, VN, num);
+    maskedEN = maskedOut.offsets[VN];
+    collapsed = true;
 }
 
 
-// initialize for label constrained BFS
-void Graph::initializeLCRsearch() {
+// snapshot of the base graph with edges added, e.g., for checking answers of an index after inserting edges, or for
+// building a new index version while the base is still queried
+// edges are given in raw ids, and edges existing in the base graph or given more than once are skipped
+Graph::Graph(const Graph& base, const vector<PerEdge>& addedEdges) {
+    double startTime = getWallTimeInMs();
+    VN = base.VN;
+    labelNum = base.labelNum;
+    labels = base.labels;
+
+    // edges of the base graph are copied in its id space, vertices are interleaved among threads
+    unsigned int num = getThreadNum();
+    vector<EdgeBuffer> buffers(num);
+    runInParallel(num, [&](unsigned int tid) {
+        EdgeBuffer& buffer = buffers[tid];
+        for (VertexID v=tid; v<VN; v+=num)
+            for (EdgeID r=base.out.runOffsets[v]; r<base.out.runOffsets[v+1]; ++r)
+                for (EdgeID e=base.out.runStarts[r]; e<base.out.runStarts[r+1]; ++e) {
+                    buffer.fromIds.emplace_back(v);
+                    buffer.toIds.emplace_back(base.out.ids[e]);
+                    buffer.labels.emplace_back(base.out.runLabels[r]);
+                }
+    });
+
+    // new edges are translated into the same id space
+    vector<PerEdge> newEdges;
+    for (const PerEdge& e : addedEdges) {
+        const VertexID s = base.toNewId(e.src), t = base.toNewId(e.dst);
+        if (s!=t && base.out.hasEdge(s, t, e.label)==false)
+            newEdges.emplace_back(s, t, e.label);
+    }
+    sort(newEdges.begin(), newEdges.end(), [](const PerEdge& a, const PerEdge& b) {
+        return a.src!=b.src ? a.src<b.src : (a.dst!=b.dst ? a.dst<b.dst : a.label<b.label);
+    });
+    newEdges.erase(unique(newEdges.begin(), newEdges.end(), [](const PerEdge& a, const PerEdge& b) {
+        return a.src==b.src && a.dst==b.dst && a.label==b.label;
+    }), newEdges.end());
+    for (const PerEdge& e : newEdges) {
+        buffers[0].fromIds.emplace_back(e.src);
+        buffers[0].toIds.emplace_back(e.dst);
+        buffers[0].labels.emplace_back(e.label);
+    }
+    EN = base.EN + newEdges.size();
+    adjEN = base.adjEN + newEdges.size();
+    buildCSR(out, VN, adjEN, buffers, false, num);
+    buildCSR(in, VN, adjEN, buffers, true, num);
+
+    // keep vertex ids of the base graph, so that query endpoints are translated in the same way
+    if (base.reordered) {
+        raw2new = new VertexID[VN];
+        new2raw = new VertexID[VN];
+        copy(base.raw2new, base.raw2new+VN, raw2new);
+        copy(base.new2raw, base.new2raw+VN, new2raw);
+        reordered = true;
+    }
+    if (base.collapsed)
+        collapse();
+    printf("- Snapshot with %d new edges, |V|=%d, |E|=%d. Time cost: %.0fms\n", int(newEdges.size()), VN, EN, getWallTimeInMs()-startTime);
+}
+
+
+// rebuild CSR neighbors in the new id space, neighbors of each run are sorted by new ids again
+static void permuteCSR(CSRneighbors& adj, const VertexID& VN, const VertexID* raw2new, const VertexID* new2raw, bool freeOld, const unsigned int& num) {
+    CSRneighbors res;
+    res.runN = adj.runN;
+    res.offsets = new EdgeID[VN+1];
+    res.runOffsets = new EdgeID[VN+1];
+    res.offsets[0] = res.runOffsets[0] = 0;
+    for (VertexID i=0; i<VN; ++i) {
+        const VertexID& v = new2raw[i];
+        res.offsets[i+1] = res.offsets[i] + adj.degree(v);
+        res.runOffsets[i+1] = res.runOffsets[i] + (adj.runOffsets[v+1]-adj.runOffsets[v]);
+    }
+    res.ids = new VertexID[res.offsets[VN]];
+    res.runLabels = new LabelID[res.runN];
+    res.runStarts = new EdgeID[res.runN+1];
+    res.runStarts[res.runN] = res.offsets[VN];
+
+    // copy label runs of each vertex, vertices are interleaved among threads
+    runInParallel(num, [&](unsigned int tid) {
+        for (VertexID i=tid; i<VN; i+=num) {
+            const VertexID& v = new2raw[i];
+            for (EdgeID r=adj.runOffsets[v], nr=res.runOffsets[i]; r<adj.runOffsets[v+1]; ++r, ++nr) {
+                res.runLabels[nr] = adj.runLabels[r];
+                res.runStarts[nr] = res.offsets[i] + (adj.runStarts[r]-adj.offsets[v]);
+                for (EdgeID e=adj.runStarts[r], ne=res.runStarts[nr]; e<adj.runStarts[r+1]; ++e, ++ne)
+                    res.ids[ne] = raw2new[adj.ids[e]];
+                sort(res.ids+res.runStarts[nr], res.ids+res.runStarts[nr]+(adj.runStarts[r+1]-adj.runStarts[r]));
+            }
+        }
+    });
+
+    if (freeOld) {
+        delete[] adj.offsets;
+        delete[] adj.ids;
+        delete[] adj.runOffsets;
+        delete[] adj.runLabels;
+        delete[] adj.runStarts;
+    }
+    adj = res;
+}
+
+
+// reverse Cuthill-McKee order on the undirected graph, i.e., BFS from low-degree vertices
+vector<VertexID> Graph::getRCMorder() {
+    auto degree = [&](const VertexID& v) { return in.degree(v)+out.degree(v); };
+    auto cmpByDegree = [&](const VertexID& a, const VertexID& b) { return degree(a)<degree(b); };
+
+    vector<VertexID> starts(VN), order, nbrs;
+    for (VertexID v=0; v<VN; ++v)
+        starts[v] = v;
+    stable_sort(starts.begin(), starts.end(), cmpByDegree);
+
+    vector<bool> visited(VN, false);
+    order.reserve(VN);
+    for (const VertexID& start : starts) {
+        if (visited[start])
+            continue;
+        visited[start] = true;
+        order.emplace_back(start);
+        for (size_t head=order.size()-1; head<order.size(); ++head) {
+            const VertexID u = order[head];
+            nbrs.clear();
+            const CSRneighbors* adjs[2] = {&out, &in};
+            for (const CSRneighbors* adj : adjs)
+                for (EdgeID e=adj->offsets[u]; e<adj->offsets[u+1]; ++e)
+                    if (!visited[adj->ids[e]]) {
+                        visited[adj->ids[e]] = true;
+                        nbrs.emplace_back(adj->ids[e]);
+                    }
+            stable_sort(nbrs.begin(), nbrs.end(), cmpByDegree);
+            order.insert(order.end(), nbrs.begin(), nbrs.end());
+        }
+    }
+    reverse(order.begin(), order.end());
+    return order;
+}
+
+
+// hops are ranked by score descending, ties broken by degree, where the score is given by the strategy
+//   degree: in-degree + out-degree
+//   product: (in-degree+1) * (out-degree+1), i.e., paths through the vertex of length two
+//   label-degree: degree weighted by the number of distinct labels of in-edges and out-edges
+//   betweenness: sampled label constrained betweenness
+//   scc: size of the SCC containing the vertex
+//   file: the order given by hopOrderFilename
+vector<VertexID> Graph::getHopRanking(const VertexID* sccIds) {
+    double startTime = getWallTimeInMs();
+    auto degree = [&](const VertexID& v) { return in.degree(v)+out.degree(v); };
+    vector<VertexID> ranking;
+    if (hopOrderStrategy=="file")
+        ranking = readHopOrderFile(hopOrderFilename);
+    else {
+        vector<double> score(VN);
+        if (hopOrderStrategy=="degree" || (hopOrderStrategy=="scc" && sccIds==NULL)) {
+            for (VertexID v=0; v<VN; ++v)
+                score[v] = degree(v);
+        } else if (hopOrderStrategy=="product") {
+            for (VertexID v=0; v<VN; ++v)
+                score[v] = double(in.degree(v)+1)*(out.degree(v)+1);
+        } else if (hopOrderStrategy=="label-degree") {
+            for (VertexID v=0; v<VN; ++v)
+                score[v] = double(degree(v))*(in.runOffsets[v+1]-in.runOffsets[v] + out.runOffsets[v+1]-out.runOffsets[v]);
+        } else if (hopOrderStrategy=="betweenness")
+            score = getBetweennessScores();
+        else if (hopOrderStrategy=="scc") {
+            vector<VertexID> sccSize(VN, 0);
+            for (VertexID v=0; v<VN; ++v)
+                ++sccSize[sccIds[v]];
+            for (VertexID v=0; v<VN; ++v)
+                score[v] = sccSize[sccIds[v]];
+        } else {
+            cerr<<"! Error! Unknown hop ordering strategy "<<hopOrderStrategy<<endl;
+            exit(-1);
+        }
+        ranking.resize(VN);
+        for (VertexID v=0; v<VN; ++v)
+            ranking[v] = v;
+        stable_sort(ranking.begin(), ranking.end(), [&](const VertexID& a, const VertexID& b) {
+            return score[a]>score[b] || (score[a]==score[b] && degree(a)>degree(b));
+        });
+    }
+    if (hopOrderStrategy!="degree")
+        printf("- Ranked hops by %s, wall time: %.2fms\n", hopOrderStrategy.c_str(), getWallTimeInMs()-startTime);
+    return ranking;
+}
+
+
+// Brandes' dependency accumulation of label constrained BFS from sampled sources, each allowing each label with
+// probability 1/2, where samples are fixed by the seed so that the ranking is the same each time
+vector<double> Graph::getBetweennessScores() {
+    mt19937 rng(BETWEENNESS_SEED);
+    const unsigned int sampleNum = min(VN, VertexID(BETWEENNESS_SAMPLES));
+    vector<VertexID> sources(sampleNum);
+    vector<vector<char>> allowed(sampleNum, vector<char>(labelNum));
+    for (unsigned int i=0; i<sampleNum; ++i) {
+        sources[i] = rng()%VN;
+        for (LabelID l=0; l<labelNum; ++l)
+            allowed[i][l] = rng()&1;
+    }
+
+    // each thread accumulates scores of its own samples
+    const unsigned int num = min(getThreadNum(), sampleNum);
+    vector<vector<double>> scores(num);
+    atomic<unsigned int> nextSample(0);
+    runInParallel(num, [&](unsigned int tid) {
+        vector<double>& score = scores[tid];
+        score.assign(VN, 0);
+        vector<int> dist(VN, -1);
+        vector<double> sigma(VN, 0), delta(VN, 0);
+        vector<VertexID> order;
+        for (unsigned int i=nextSample++; i<sampleNum; i=nextSample++) {
+            const vector<char>& ls = allowed[i];
+            order.assign(1, sources[i]);
+            dist[sources[i]] = 0;
+            sigma[sources[i]] = 1;
+            for (size_t idx=0; idx<order.size(); ++idx) {
+                const VertexID u = order[idx];
+                for (EdgeID r=out.runOffsets[u]; r<out.runOffsets[u+1]; ++r)
+                    if (ls[out.runLabels[r]])
+                        for (EdgeID e=out.runStarts[r]; e<out.runStarts[r+1]; ++e) {
+                            const VertexID w = out.ids[e];
+                            if (dist[w]<0) {
+                                dist[w] = dist[u]+1;
+                                order.push_back(w);
+                            }
+                            if (dist[w]==dist[u]+1)
+                                sigma[w] += sigma[u];
+                        }
+            }
+
+            // vertices are visited in reverse BFS order, so dependencies of successors are complete
+            for (size_t idx=order.size(); idx-->1; ) {
+                const VertexID w = order[idx];
+                for (EdgeID r=in.runOffsets[w]; r<in.runOffsets[w+1]; ++r)
+                    if (ls[in.runLabels[r]])
+                        for (EdgeID e=in.runStarts[r]; e<in.runStarts[r+1]; ++e) {
+                            const VertexID v = in.ids[e];
+                            if (dist[v]>=0 && dist[v]+1==dist[w])
+                                delta[v] += sigma[v]/sigma[w]*(1+delta[w]);
+                        }
+                score[w] += delta[w];
+            }
+            for (const VertexID& v : order) {
+                dist[v] = -1;
+                sigma[v] = delta[v] = 0;
+            }
+        }
+    });
+    for (unsigned int tid=1; tid<num; ++tid)
+        for (VertexID v=0; v<VN; ++v)
+            scores[0][v] += scores[tid][v];
+    return scores[0];
+}
+
+
+// one raw vertex id per line, returned as new ids in the order of the file
+vector<VertexID> Graph::readVertexFile(const string& filename, const string& name) {
+    ifstream file(filename);
+    if (!file.is_open()) {
+        cerr<<"! Error! Cannot open "<<name<<" "<<filename<<endl;
+        exit(-1);
+    }
+    vector<VertexID> vertices;
+    vector<bool> given(VN, false);
+    VertexID v;
+    while (file >> v) {
+        if (v>=VN) {
+            cerr<<"! Error! Vertex "<<v<<" in "<<name<<" "<<filename<<" does not exist"<<endl;
+            exit(-1);
+        }
+        if (given[toNewId(v)]) {
+            cerr<<"! Error! Vertex "<<v<<" appears more than once in "<<name<<" "<<filename<<endl;
+            exit(-1);
+        }
+        given[toNewId(v)] = true;
+        vertices.emplace_back(toNewId(v));
+    }
+    file.close();
+    return vertices;
+}
+
+
+// one raw vertex id per line, from the highest ranked hop, and vertices not in the file are ranked after them by degree
+vector<VertexID> Graph::readHopOrderFile(const string& filename) {
+    vector<VertexID> ranking = readVertexFile(filename, "hop order file");
+    vector<bool> ranked(VN, false);
+    for (const VertexID& v : ranking)
+        ranked[v] = true;
+    size_t givenCnt = ranking.size();
+    for (VertexID v=0; v<VN; ++v)
+        if (ranked[v]==false)
+            ranking.emplace_back(v);
+    stable_sort(ranking.begin()+givenCnt, ranking.end(), [&](const VertexID& a, const VertexID& b) {
+        return in.degree(a)+out.degree(a) > in.degree(b)+out.degree(b);
+    });
+    printf("- %d hops ranked by %s, %d other hops ranked by degree\n", int(givenCnt), filename.c_str(), int(VN-givenCnt));
+    return ranking;
+}
+
+
+// relabel vertices, so that vertices accessed together are stored close to each other
+void Graph::reorder(const string& strategy) {
+    vector<VertexID> order;                         // order[i] is the raw id of new vertex i
+    if (strategy=="rcm")
+        order = getRCMorder();
+    else if (strategy=="degree") {
+        order.resize(VN);
+        for (VertexID v=0; v<VN; ++v)
+            order[v] = v;
+        stable_sort(order.begin(), order.end(), [&](const VertexID& a, const VertexID& b) {
+            return in.degree(a)+out.degree(a) > in.degree(b)+out.degree(b);
+        });
+    } else if (strategy=="hop")
+        order = getHopRanking();
+    else {
+        cerr<<"! Error! Unknown relabeling strategy "<<strategy<<endl;
+        exit(-1);
+    }
+
+    raw2new = new VertexID[VN];
+    new2raw = new VertexID[VN];
+    for (VertexID i=0; i<VN; ++i) {
+        new2raw[i] = order[i];
+        raw2new[order[i]] = i;
+    }
+
+    // arrays mapped from binary graph file are read-only, so they are replaced by new ones
+    unsigned int num = getThreadNum();
+    permuteCSR(out, VN, raw2new, new2raw, mappedFile==NULL, num);
+    permuteCSR(in, VN, raw2new, new2raw, mappedFile==NULL, num);
+    if (mappedFile) {
+        munmap(mappedFile, mappedSize);
+        mappedFile = NULL;
+    }
+    reordered = true;
+}
+
+
+// arrays of CSR neighbors stored in binary graph file, in order
+static vector<pair<char**, size_t>> getBinaryArrays(CSRneighbors& adj, const VertexID& VN, const EdgeID& adjEN) {
+    return {{(char**)&adj.offsets, sizeof(EdgeID)*(size_t(VN)+1)},
+            {(char**)&adj.ids, sizeof(VertexID)*size_t(adjEN)},
+            {(char**)&adj.runOffsets, sizeof(EdgeID)*(size_t(VN)+1)},
+            {(char**)&adj.runLabels, sizeof(LabelID)*size_t(adj.runN)},
+            {(char**)&adj.runStarts, sizeof(EdgeID)*(size_t(adj.runN)+1)}};
+}
+
+
+// map the binary graph file into memory, return false if it is not a binary graph file
+bool Graph::loadBinary(const string& filename) {
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd<0) {
+        cerr<<"! Error! Cannot open "<<filename<<endl;
+        exit(-1);
+    }
+
+    // check the header
+    struct stat fileStat;
+    BinaryGraphHeader header;
+    if (fstat(fd, &fileStat)!=0 || size_t(fileStat.st_size)<sizeof(header) || 
+        pread(fd, &header, sizeof(header), 0)!=sizeof(header) || strncmp(header.magic, BINARY_GRAPH_MAGIC, sizeof(header.magic))!=0) {
+        close(fd);
+        return false;
+    }
+    if (header.version!=BINARY_GRAPH_VERSION) {
+        cerr<<"! Error! Binary graph version "<<header.version<<" is not supported, please convert "<<filename<<" again!"<<endl;
+        exit(-1);
+    }
+    VN = header.VN;
+    EN = header.EN;
+    labelNum = header.labelNum;
+    adjEN = header.adjEN;
+    out.runN = header.outRunN;
+    in.runN = header.inRunN;
+    size_t expectedSize = sizeof(header);
+    CSRneighbors* adjs[2] = {&out, &in};
+    for (CSRneighbors* adj : adjs)
+        for (const auto& array : getBinaryArrays(*adj, VN, adjEN))
+            expectedSize += array.second;
+    if (size_t(fileStat.st_size)!=expectedSize) {
+        cerr<<"! Error! Binary graph file "<<filename<<" is truncated or corrupted!"<<endl;
+        exit(-1);
+    }
+
+    // map into memory, pages are shared by all processes reading the same file
+    mappedSize = fileStat.st_size;
+    mappedFile = mmap(NULL, mappedSize, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mappedFile==MAP_FAILED) {
+        cerr<<"! Error! Cannot map "<<filename<<" into memory!"<<endl;
+        exit(-1);
+    }
+
+    // arrays are stored one after another, following the header
+    char* cur = (char*)mappedFile + sizeof(header);
+    for (CSRneighbors* adj : adjs)
+        for (const auto& array : getBinaryArrays(*adj, VN, adjEN)) {
+            *array.first = cur;
+            cur += array.second;
+        }
+    return true;
+}
+
+
+// dump graph in binary format
+void Graph::writeBinary(const string& filename) {
+    BinaryGraphHeader header;
+    memset(&header, 0, sizeof(header));
+    strncpy(header.magic, BINARY_GRAPH_MAGIC, sizeof(header.magic));
+    header.version = BINARY_GRAPH_VERSION;
+    header.VN = VN;
+    header.EN = EN;
+    header.labelNum = labelNum;
+    header.adjEN = adjEN;
+    header.outRunN = out.runN;
+    header.inRunN = in.runN;
+
+    ofstream outputFile(filename, ios::binary);
+    outputFile.write((const char*)&header, sizeof(header));
+    CSRneighbors* adjs[2] = {&out, &in};
+    for (CSRneighbors* adj : adjs)
+        for (const auto& array : getBinaryArrays(*adj, VN, adjEN))
+            outputFile.write(*array.first, array.second);
+    outputFile.close();
+    if (!outputFile) {
+        cerr<<"! Error! Cannot write "<<filename<<endl;
+        exit(-1);
+    }
+}
+
+
+// memory used by the adjacency of both directions
+double Graph::getGraphSizeInBytes() {
+    double size = 0;
+    CSRneighbors* adjs[2] = {&out, &in};
+    for (CSRneighbors* adj : adjs)
+        for (const auto& array : getBinaryArrays(*adj, VN, adjEN))
+            size += array.second;
+    return size;
+}
+
+
+// checksum of the adjacency of both directions (after relabeling), for checking whether an index file matches the graph
+unsigned long long Graph::getChecksum() {
+    unsigned long long h = checksum64(&VN, sizeof(VN));
+    CSRneighbors* adjs[2] = {&out, &in};
+    for (CSRneighbors* adj : adjs)
+        for (const auto& array : getBinaryArrays(*adj, VN, adjEN))
+            h = checksum64(*array.first, array.second, h);
+    return h;
+}
+
+// scratch state for online searches on a graph with n vertices
+SearchContext::SearchContext(const VertexID& n) {
+    VN = n;
     visited = new VertexID[VN]();
     Q = new VertexID[VN];
-    initialized = true;
+    visitedT = new VertexID[VN]();
+    QT = new VertexID[VN];
+    inFrontier = new unsigned long long[VN/64+1]();
+}
+
+
+SearchContext::~SearchContext() {
+    delete[] visited;
+    delete[] Q;
+    delete[] visitedT;
+    delete[] QT;
+    delete[] inFrontier;
+    if (seen) {
+        delete[] seen;
+        delete[] visit;
+        delete[] visitNext;
+    }
+}
+
+
+// start a new search, all marks are cleared when offset wraps around
+void SearchContext::newSearch() {
+    if (++offset >= INT_MAX) {
+        offset = 1;
+        memset(visited, 0, sizeof(VertexID)*VN);
+        memset(visitedT, 0, sizeof(VertexID)*VN);
+    }
+}
+
+
+// initialize the default context used by searches without a given context
+void Graph::initializeLCRsearch() {
+    if (defaultContext==NULL)
+        defaultContext = new SearchContext(VN);
+}
+
+
+// a context owned by the caller, for running searches on the same graph concurrently
+SearchContext* Graph::newSearchContext() const {
+    return new SearchContext(VN);
 }
 
 
 // label constrained BFS for graphs with small number of labels
-bool Graph::LCRsearch(const VertexID& s, const VertexID& t, const LabelSet& labelSet) {
-    if (s==t)
+bool Graph::LCRsearch(const VertexID& rawS, const VertexID& rawT, const LabelSet& labelSet, SearchContext* ctx) const {
+    if (rawS==rawT)
         return true;  
-    if (offset >= INT_MAX) {
-        offset = 1;
-        memset(visited, 0, sizeof visited);
+    if (directionOptimizing)
+        return doLCRsearch(rawS, rawT, labelSet, ctx);
+    SearchContext& c = ctx ? *ctx : *defaultContext;
+    const VertexID s = toNewId(rawS), t = toNewId(rawT);
+    c.newSearch();
+    
+    VertexID queueBegin = 0, queueEnd = 1;
+    c.visited[s] = c.offset;
+    c.Q[queueBegin] = s;
+
+    while (queueBegin<queueEnd) {
+        const VertexID& cur = c.Q[queueBegin];
+        ++queueBegin;
+
+        // parallel edges are collapsed, i.e., one AND per neighbor
+        if (collapsed) {
+            for (EdgeID e=maskedOut.offsets[cur]; e<maskedOut.offsets[cur+1]; ++e)
+                if (maskedOut.masks[e] & labelSet) {
+                    const VertexID& nxt = maskedOut.ids[e];
+                    if (nxt==t)
+                        return true;
+                    if (c.visited[nxt]<c.offset) {
+                        c.visited[nxt] = c.offset;
+                        c.Q[queueEnd++] = nxt;
+                    }
+                }
+            continue;
+        }
+
+        for (EdgeID r=out.runOffsets[cur]; r<out.runOffsets[cur+1]; ++r)
+            if ((1<<(out.runLabels[r])) & labelSet)
+                for (EdgeID e=out.runStarts[r]; e<out.runStarts[r+1]; ++e) {
+                    const VertexID& nxt = out.ids[e];
+                    if (nxt==t)
+                        return true;
+                    if (c.visited[nxt]<c.offset) {
+                        c.visited[nxt] = c.offset;
+                        c.Q[queueEnd++] = nxt;
+                    }
+                }
+    }
+    return false;
+}
+
+
+// label constrained BFS for graphs with large number of labels
+bool Graph::LCRsearch(const VertexID& rawS, const VertexID& rawT, const vector<LabelID>& lls, SearchContext* ctx) const {
+    if (rawS==rawT)
+        return true;  
+
+    // all labels fit in a label set when parallel edges are collapsed
+    if (collapsed) {
+        LabelSet labelSet = 0;
+        for (const LabelID& label : lls)
+            labelSet |= 1<<label;
+        return LCRsearch(rawS, rawT, labelSet, ctx);
     }
+    if (directionOptimizing)
+        return doLCRsearch(rawS, rawT, lls, ctx);
+    SearchContext& c = ctx ? *ctx : *defaultContext;
+    const VertexID s = toNewId(rawS), t = toNewId(rawT);
+    c.newSearch();
     
-    queueBegin = 0;
-    queueEnd = 1;
-    visited[s] = offset;
-    Q[queueBegin] = s;
+    VertexID queueBegin = 0, queueEnd = 1;
+    c.visited[s] = c.offset;
+    c.Q[queueBegin] = s;
 
     while (queueBegin<queueEnd) {
-        const VertexID& cur = Q[queueBegin];
+        const VertexID& cur = c.Q[queueBegin];
         ++queueBegin;
 
-        for (auto iter = neighbors[cur].out.begin(); iter!=neighbors[cur].out.end(); ++iter)
-            if ((1<<(iter->first)) & labelSet)
-                for (int j=0; j<iter->second.size(); ++j) {
-                    const VertexID& nxt = iter->second[j];
-                    if (nxt==t) {
-                        ++offset;
+        for (const LabelID& label : lls) {
+            const EdgeID r = out.findRun(cur, label);
+            if (r<out.runOffsets[cur+1])
+                for (EdgeID e=out.runStarts[r]; e<out.runStarts[r+1]; ++e) {
+                    const VertexID& nxt = out.ids[e];
+                    if (nxt==t)
                         return true;
-                    } else 
-                        if (visited[nxt]<offset) {
-                            visited[nxt] = offset;
-                            Q[queueEnd++] = nxt;
-                        }
+                    if (c.visited[nxt]<c.offset) {
+                        c.visited[nxt] = c.offset;
+                        c.Q[queueEnd++] = nxt;
+                    }
                 }
+        }
     }
+    return false;
+}
+
+
+// expand one whole level of a bidirectional search, return true if meeting the other direction
+bool Graph::expandLevel(const CSRneighbors& adj, const MaskedNeighbors& masked, VertexID* q, VertexID& qBegin, VertexID& qEnd, VertexID* mine, const VertexID* other, const VertexID& offset, const LabelSet& labelSet) const {
+    const VertexID levelEnd = qEnd;
+    while (qBegin<levelEnd) {
+        const VertexID& cur = q[qBegin];
+        ++qBegin;
 
-    ++offset;
+        if (collapsed) {
+            for (EdgeID e=masked.offsets[cur]; e<masked.offsets[cur+1]; ++e)
+                if (masked.masks[e] & labelSet) {
+                    const VertexID& nxt = masked.ids[e];
+                    if (other[nxt]==offset)
+                        return true;
+                    if (mine[nxt]<offset) {
+                        mine[nxt] = offset;
+                        q[qEnd++] = nxt;
+                    }
+                }
+            continue;
+        }
+
+        for (EdgeID r=adj.runOffsets[cur]; r<adj.runOffsets[cur+1]; ++r)
+            if ((1<<(adj.runLabels[r])) & labelSet)
+                for (EdgeID e=adj.runStarts[r]; e<adj.runStarts[r+1]; ++e) {
+                    const VertexID& nxt = adj.ids[e];
+                    if (other[nxt]==offset)
+                        return true;
+                    if (mine[nxt]<offset) {
+                        mine[nxt] = offset;
+                        q[qEnd++] = nxt;
+                    }
+                }
+    }
     return false;
 }
 
 
-// label constrained BFS for graphs with small number of labels
-bool Graph::LCRsearch(const VertexID& s, const VertexID& t, const vector<LabelID>& lls) {
-    if (s==t)
+// expand one whole level of a bidirectional search, return true if meeting the other direction
+bool Graph::expandLevel(const CSRneighbors& adj, VertexID* q, VertexID& qBegin, VertexID& qEnd, VertexID* mine, const VertexID* other, const VertexID& offset, const vector<LabelID>& lls) const {
+    const VertexID levelEnd = qEnd;
+    while (qBegin<levelEnd) {
+        const VertexID& cur = q[qBegin];
+        ++qBegin;
+
+        for (const LabelID& label : lls) {
+            const EdgeID r = adj.findRun(cur, label);
+            if (r<adj.runOffsets[cur+1])
+                for (EdgeID e=adj.runStarts[r]; e<adj.runStarts[r+1]; ++e) {
+                    const VertexID& nxt = adj.ids[e];
+                    if (other[nxt]==offset)
+                        return true;
+                    if (mine[nxt]<offset) {
+                        mine[nxt] = offset;
+                        q[qEnd++] = nxt;
+                    }
+                }
+        }
+    }
+    return false;
+}
+
+
+// label constrained bidirectional BFS for graphs with small number of labels
+// forward search from s over out-edges and backward search from t over in-edges, the smaller frontier is expanded
+bool Graph::biLCRsearch(const VertexID& rawS, const VertexID& rawT, const LabelSet& labelSet, SearchContext* ctx) const {
+    if (rawS==rawT)
         return true;  
-    if (offset >= INT_MAX) {
-        offset = 1;
-        memset(visited, 0, sizeof visited);
+    SearchContext& c = ctx ? *ctx : *defaultContext;
+    const VertexID s = toNewId(rawS), t = toNewId(rawT);
+    c.newSearch();
+
+    VertexID beginS = 0, endS = 1, beginT = 0, endT = 1;
+    c.visited[s] = c.offset;
+    c.Q[0] = s;
+    c.visitedT[t] = c.offset;
+    c.QT[0] = t;
+
+    while (beginS<endS && beginT<endT) {
+        bool found;
+        if (endS-beginS <= endT-beginT)
+            found = expandLevel(out, maskedOut, c.Q, beginS, endS, c.visited, c.visitedT, c.offset, labelSet);
+        else
+            found = expandLevel(in, maskedIn, c.QT, beginT, endT, c.visitedT, c.visited, c.offset, labelSet);
+        if (found)
+            return true;
     }
-    
-    queueBegin = 0;
-    queueEnd = 1;
+    return false;
+}
+
+
+// label constrained bidirectional BFS for graphs with large number of labels
+bool Graph::biLCRsearch(const VertexID& rawS, const VertexID& rawT, const vector<LabelID>& lls, SearchContext* ctx) const {
+    if (rawS==rawT)
+        return true;  
+
+    // all labels fit in a label set when parallel edges are collapsed
+    if (collapsed) {
+        LabelSet labelSet = 0;
+        for (const LabelID& label : lls)
+            labelSet |= 1<<label;
+        return biLCRsearch(rawS, rawT, labelSet, ctx);
+    }
+    SearchContext& c = ctx ? *ctx : *defaultContext;
+    const VertexID s = toNewId(rawS), t = toNewId(rawT);
+    c.newSearch();
+
+    VertexID beginS = 0, endS = 1, beginT = 0, endT = 1;
+    c.visited[s] = c.offset;
+    c.Q[0] = s;
+    c.visitedT[t] = c.offset;
+    c.QT[0] = t;
+
+    while (beginS<endS && beginT<endT) {
+        bool found;
+        if (endS-beginS <= endT-beginT)
+            found = expandLevel(out, c.Q, beginS, endS, c.visited, c.visitedT, c.offset, lls);
+        else
+            found = expandLevel(in, c.QT, beginT, endT, c.visitedT, c.visited, c.offset, lls);
+        if (found)
+            return true;
+    }
+    return false;
+}
+
+
+// whether v has an in-neighbor in the frontier via an edge with label in the label set
+inline bool Graph::hasParentInFrontier(const VertexID& v, const unsigned long long* inFrontier, const LabelSet& labelSet, const vector<LabelID>* lls) const {
+    if (collapsed) {
+        for (EdgeID e=maskedIn.offsets[v]; e<maskedIn.offsets[v+1]; ++e)
+            if ((maskedIn.masks[e] & labelSet) && (inFrontier[maskedIn.ids[e]>>6]>>(maskedIn.ids[e]&63) & 1))
+                return true;
+        return false;
+    }
+    for (EdgeID r=in.runOffsets[v]; r<in.runOffsets[v+1]; ++r) {
+        if (lls ? find(lls->begin(), lls->end(), in.runLabels[r])==lls->end() : ((1<<(in.runLabels[r])) & labelSet)==0)
+            continue;
+        for (EdgeID e=in.runStarts[r]; e<in.runStarts[r+1]; ++e)
+            if (inFrontier[in.ids[e]>>6]>>(in.ids[e]&63) & 1)
+                return true;
+    }
+    return false;
+}
+
+
+// direction-optimizing BFS with heuristics of Beamer et al., switching from top-down to bottom-up steps
+// when edges to check from the frontier exceed 1/DO_ALPHA of unexplored edges, and switching back when
+// the frontier contains less than 1/DO_BETA of all vertices
+#define DO_ALPHA 14
+#define DO_BETA 24
+bool Graph::directionSearch(const VertexID& s, const VertexID& t, const LabelSet& labelSet, const vector<LabelID>* lls, SearchContext& c) const {
+    c.newSearch();
+    VertexID* visited = c.visited;
+    VertexID* Q = c.Q;
+    unsigned long long* inFrontier = c.inFrontier;
+    const VertexID offset = c.offset;
+
+    VertexID queueBegin = 0, queueEnd = 1;
     visited[s] = offset;
     Q[queueBegin] = s;
 
+    // edges out of the frontier and edges out of unexplored vertices, using unfiltered degrees as estimations
+    double frontierEdges = out.degree(s), unexploredEdges = adjEN-out.degree(s);
+    bool bottomUp = false;
+
     while (queueBegin<queueEnd) {
-        const VertexID& cur = Q[queueBegin];
-        ++queueBegin;
+        const VertexID levelEnd = queueEnd;
+        if (bottomUp==false && frontierEdges > unexploredEdges/DO_ALPHA)
+            bottomUp = true;
+        else if (bottomUp && double(levelEnd-queueBegin) < double(VN)/DO_BETA)
+            bottomUp = false;
+        frontierEdges = 0;
 
-        for (const LabelID& label : lls)
-            if (neighbors[cur].out.find(label)!=neighbors[cur].out.end())
-                for (int j=0; j<neighbors[cur].out[label].size(); ++j) {
-                    const VertexID& nxt = neighbors[cur].out[label][j];
-                    if (nxt==t) {
-                        ++offset;
-                        return true;
-                    } else 
+        // top-down step, scanning out-edges of the frontier
+        if (bottomUp==false) {
+            while (queueBegin<levelEnd) {
+                const VertexID& cur = Q[queueBegin];
+                ++queueBegin;
+
+                if (collapsed) {
+                    for (EdgeID e=maskedOut.offsets[cur]; e<maskedOut.offsets[cur+1]; ++e)
+                        if (maskedOut.masks[e] & labelSet) {
+                            const VertexID& nxt = maskedOut.ids[e];
+                            if (nxt==t)
+                                return true;
+                            if (visited[nxt]<offset) {
+                                visited[nxt] = offset;
+                                Q[queueEnd++] = nxt;
+                                frontierEdges += out.degree(nxt);
+                            }
+                        }
+                    continue;
+                }
+
+                for (EdgeID r=out.runOffsets[cur]; r<out.runOffsets[cur+1]; ++r) {
+                    if (lls ? find(lls->begin(), lls->end(), out.runLabels[r])==lls->end() : ((1<<(out.runLabels[r])) & labelSet)==0)
+                        continue;
+                    for (EdgeID e=out.runStarts[r]; e<out.runStarts[r+1]; ++e) {
+                        const VertexID& nxt = out.ids[e];
+                        if (nxt==t)
+                            return true;
                         if (visited[nxt]<offset) {
                             visited[nxt] = offset;
                             Q[queueEnd++] = nxt;
+                            frontierEdges += out.degree(nxt);
                         }
+                    }
                 }
+            }
+            unexploredEdges -= frontierEdges;
+            continue;
+        }
+
+        // bottom-up step, each unvisited vertex checks its in-edges until finding a parent in the frontier
+        // t is checked first, so that the step stops without scanning other vertices once t is reached
+        for (VertexID i=queueBegin; i<levelEnd; ++i)
+            inFrontier[Q[i]>>6] |= 1ULL<<(Q[i]&63);
+        if (hasParentInFrontier(t, inFrontier, labelSet, lls)) {
+            for (VertexID i=queueBegin; i<levelEnd; ++i)
+                inFrontier[Q[i]>>6] = 0;
+            return true;
+        }
+        for (VertexID v=0; v<VN; ++v)
+            if (visited[v]<offset && v!=t && hasParentInFrontier(v, inFrontier, labelSet, lls)) {
+                visited[v] = offset;
+                Q[queueEnd++] = v;
+                frontierEdges += out.degree(v);
+            }
+        for (; queueBegin<levelEnd; ++queueBegin)
+            inFrontier[Q[queueBegin]>>6] = 0;
+        unexploredEdges -= frontierEdges;
     }
 
-    ++offset;
     return false;
 }
 
 
+// direction-optimizing label constrained BFS for graphs with small number of labels
+bool Graph::doLCRsearch(const VertexID& rawS, const VertexID& rawT, const LabelSet& labelSet, SearchContext* ctx) const {
+    if (rawS==rawT)
+        return true;  
+    return directionSearch(toNewId(rawS), toNewId(rawT), labelSet, NULL, ctx ? *ctx : *defaultContext);
+}
+
+
+// direction-optimizing label constrained BFS for graphs with large number of labels
+bool Graph::doLCRsearch(const VertexID& rawS, const VertexID& rawT, const vector<LabelID>& lls, SearchContext* ctx) const {
+    if (rawS==rawT)
+        return true;  
+
+    // all labels fit in a label set when parallel edges are collapsed
+    if (collapsed) {
+        LabelSet labelSet = 0;
+        for (const LabelID& label : lls)
+            labelSet |= 1<<label;
+        return directionSearch(toNewId(rawS), toNewId(rawT), labelSet, NULL, ctx ? *ctx : *defaultContext);
+    }
+    return directionSearch(toNewId(rawS), toNewId(rawT), 0, &lls, ctx ? *ctx : *defaultContext);
+}
+
+
+// answer at most BATCH_SEARCH_WIDTH queries s->t with the same label set by one multi-source BFS
+// label set is given by labelSet, or by lls if it is not NULL and parallel edges are not collapsed
+void Graph::multiSourceSearch(const VertexID* S, const VertexID* T, unsigned int n, const LabelSet& labelSet, const vector<LabelID>* lls, vector<bool>& answers, size_t ansOffset, SearchContext& c) const {
+    if (c.seen==NULL) {
+        c.seen = new BatchMask[VN]();
+        c.visit = new BatchMask[VN]();
+        c.visitNext = new BatchMask[VN]();
+    }
+    BatchMask* seen = c.seen;
+    vector<VertexID>& batchFrontier = c.batchFrontier;
+    vector<VertexID>& batchNxtFrontier = c.batchNxtFrontier;
+    vector<VertexID>& batchTouched = c.batchTouched;
+
+    // sources
+    BatchMask active = 0;
+    for (unsigned int i=0; i<n; ++i) {
+        const BatchMask bit = 1ULL<<i;
+        const VertexID s = toNewId(S[i]);
+        answers[ansOffset+i] = (S[i]==T[i]);
+        if (answers[ansOffset+i])
+            continue;
+        active |= bit;
+        if (seen[s]==0)
+            batchTouched.push_back(s);
+        if (c.visit[s]==0)
+            batchFrontier.push_back(s);
+        seen[s] |= bit;
+        c.visit[s] |= bit;
+    }
+
+    while (active && !batchFrontier.empty()) {
+
+        // one adjacency scan of cur advances all searches in visit[cur]
+        for (const VertexID& cur : batchFrontier) {
+            const BatchMask bits = c.visit[cur] & active;
+            c.visit[cur] = 0;
+            if (bits==0)
+                continue;
+
+            if (collapsed) {
+                for (EdgeID e=maskedOut.offsets[cur]; e<maskedOut.offsets[cur+1]; ++e)
+                    if (maskedOut.masks[e] & labelSet) {
+                        const VertexID& nxt = maskedOut.ids[e];
+                        const BatchMask newBits = bits & ~seen[nxt];
+                        if (newBits==0)
+                            continue;
+                        if (seen[nxt]==0)
+                            batchTouched.push_back(nxt);
+                        if (c.visitNext[nxt]==0)
+                            batchNxtFrontier.push_back(nxt);
+                        seen[nxt] |= newBits;
+                        c.visitNext[nxt] |= newBits;
+                    }
+                continue;
+            }
+
+            for (EdgeID r=out.runOffsets[cur]; r<out.runOffsets[cur+1]; ++r) {
+                if (lls ? find(lls->begin(), lls->end(), out.runLabels[r])==lls->end() : ((1<<(out.runLabels[r])) & labelSet)==0)
+                    continue;
+                for (EdgeID e=out.runStarts[r]; e<out.runStarts[r+1]; ++e) {
+                    const VertexID& nxt = out.ids[e];
+                    const BatchMask newBits = bits & ~seen[nxt];
+                    if (newBits==0)
+                        continue;
+                    if (seen[nxt]==0)
+                        batchTouched.push_back(nxt);
+                    if (c.visitNext[nxt]==0)
+                        batchNxtFrontier.push_back(nxt);
+                    seen[nxt] |= newBits;
+                    c.visitNext[nxt] |= newBits;
+                }
+            }
+        }
+        swap(c.visit, c.visitNext);
+        batchFrontier.swap(batchNxtFrontier);
+        batchNxtFrontier.clear();
+
+        // searches reaching their targets are finished
+        for (unsigned int i=0; i<n; ++i)
+            if ((active>>i & 1) && (seen[toNewId(T[i])]>>i & 1)) {
+                answers[ansOffset+i] = true;
+                active &= ~(1ULL<<i);
+            }
+    }
+
+    // reset for next batch
+    for (const VertexID& v : batchFrontier)
+        c.visit[v] = 0;
+    for (const VertexID& v : batchTouched)
+        seen[v] = 0;
+    batchFrontier.clear();
+    batchTouched.clear();
+}
+
+
+// answer queries S[i]->T[i] with the same label set, for graphs with small number of labels
+void Graph::LCRsearchBatch(const vector<VertexID>& S, const vector<VertexID>& T, const LabelSet& labelSet, vector<bool>& answers, SearchContext* ctx) const {
+    answers.assign(S.size(), false);
+    for (size_t i=0; i<S.size(); i+=BATCH_SEARCH_WIDTH)
+        multiSourceSearch(&S[i], &T[i], min(S.size()-i, (size_t)BATCH_SEARCH_WIDTH), labelSet, NULL, answers, i, ctx ? *ctx : *defaultContext);
+}
+
+
+// answer queries S[i]->T[i] with the same label set, for graphs with large number of labels
+void Graph::LCRsearchBatch(const vector<VertexID>& S, const vector<VertexID>& T, const vector<LabelID>& lls, vector<bool>& answers, SearchContext* ctx) const {
+
+    // all labels fit in a label set when parallel edges are collapsed
+    LabelSet labelSet = 0;
+    if (collapsed)
+        for (const LabelID& label : lls)
+            labelSet |= 1<<label;
+
+    answers.assign(S.size(), false);
+    for (size_t i=0; i<S.size(); i+=BATCH_SEARCH_WIDTH)
+        multiSourceSearch(&S[i], &T[i], min(S.size()-i, (size_t)BATCH_SEARCH_WIDTH), labelSet, collapsed ? NULL : &lls, answers, i, ctx ? *ctx : *defaultContext);
+}
+
+
+// answer arbitrary queries, which are grouped by label set and answered batch by batch
+void Graph::LCRsearchBatch(const vector<PerQuery>& queries, bool largeLabelSet, vector<bool>& answers, SearchContext* ctx) const {
+    answers.assign(queries.size(), false);
+    map<vector<LabelID>, vector<size_t>> groups;
+    for (size_t i=0; i<queries.size(); ++i) {
+        vector<LabelID> key;
+        if (largeLabelSet) {
+            key = queries[i].lls;
+            sort(key.begin(), key.end());
+        } else 
+            key.push_back(queries[i].ls);
+        groups[key].push_back(i);
+    }
+
+    vector<VertexID> S, T;
+    vector<bool> groupAnswers;
+    for (const auto& group : groups) {
+        S.clear();
+        T.clear();
+        for (const size_t& i : group.second) {
+            S.push_back(queries[i].s);
+            T.push_back(queries[i].t);
+        }
+        if (largeLabelSet)
+            LCRsearchBatch(S, T, group.first, groupAnswers, ctx);
+        else 
+            LCRsearchBatch(S, T, (LabelSet)group.first[0], groupAnswers, ctx);
+        for (size_t j=0; j<group.second.size(); ++j)
+            answers[group.second[j]] = groupAnswers[j];
+    }
+}
+
+
 #endif
\ No newline at end of file
@@ -11,11 +11,74 @@ C++ 11
 #define GRAPH_H
 #include "Utils.h"
 
-// storage structure for raw graph data 
-struct PerNeighbor{
-    unordered_map<LabelID, vector<VertexID>> in;    // vector of in-neighbors of vertex v
-    unordered_map<LabelID, vector<VertexID>> out;   // vector of out-neighbors of vertex v
-    VertexID inDegree=0, outDegree=0;
+// storage structure for raw graph data in one direction, i.e., compressed sparse row (CSR)
+// neighbors of vertex v are ids[offsets[v]...offsets[v+1]-1], sorted by (label, neighbor id), and
+// they are partitioned into label runs [runOffsets[v], runOffsets[v+1]), where the r-th run
+// contains neighbors ids[runStarts[r]...runStarts[r+1]-1] with the same label runLabels[r]
+struct CSRneighbors{
+    EdgeID* offsets;                                // VN+1 offsets into ids
+    VertexID* ids;                                  // neighbor ids
+    EdgeID* runOffsets;                             // VN+1 offsets into label runs
+    LabelID* runLabels;                             // label of each run
+    EdgeID* runStarts;                              // runN+1 offsets into ids
+    EdgeID runN;                                    // number of label runs
+    inline EdgeID degree(const VertexID& v) const { return offsets[v+1]-offsets[v]; }
+
+    // the run with label l among v's label runs, or runOffsets[v+1] if not exists
+    inline EdgeID findRun(const VertexID& v, const LabelID& l) const {
+        EdgeID r = lower_bound(runLabels+runOffsets[v], runLabels+runOffsets[v+1], l) - runLabels;
+        return (r<runOffsets[v+1] && runLabels[r]==l) ? r : runOffsets[v+1];
+    }
+
+    // whether edge (v, u) with label l exists
+    inline bool hasEdge(const VertexID& v, const VertexID& u, const LabelID& l) const {
+        EdgeID r = findRun(v, l);
+        return r<runOffsets[v+1] && binary_search(ids+runStarts[r], ids+runStarts[r+1], u);
+    }
+};
+
+// parallel edges between the same pair of vertices are merged into one entry with label set masks[e]
+// neighbors of vertex v are ids[offsets[v]...offsets[v+1]-1], sorted by neighbor id
+struct MaskedNeighbors{
+    EdgeID* offsets;                                // VN+1 offsets into ids and masks
+    VertexID* ids;                                  // neighbor ids
+    LabelSet* masks;                                // labels of all edges linking to the neighbor
+};
+
+// header of binary graph file, followed by out and in CSR arrays (offsets, ids, runOffsets, runLabels, runStarts)
+#define BINARY_GRAPH_MAGIC "LCRCSR"
+#define BINARY_GRAPH_VERSION 2
+struct BinaryGraphHeader{
+    char magic[8];
+    unsigned int version;
+    VertexID VN;
+    EdgeID EN;                                      // number of edges in the text file
+    LabelID labelNum;
+    EdgeID adjEN;                                   // number of edges after removing self-loops
+    EdgeID outRunN, inRunN;                         // number of label runs
+    unsigned int reserved;
+};
+
+// one bit per query in a batch of multi-source label constrained BFS
+typedef unsigned long long BatchMask;
+#define BATCH_SEARCH_WIDTH 64
+
+// sources of label constrained BFS sampled for ranking hops by betweenness, each with a random label set
+#define BETWEENNESS_SAMPLES 64
+#define BETWEENNESS_SEED 2022
+
+// scratch state of online label constrained searches, each thread owns its own context
+struct SearchContext{
+    VertexID VN;
+    VertexID offset = 0;                            // visited[v]==offset if v is visited in current search
+    VertexID *visited, *Q;                          // forward search
+    VertexID *visitedT, *QT;                        // backward search of bidirectional BFS
+    unsigned long long* inFrontier;                 // frontier bitmap of bottom-up steps
+    BatchMask *seen = NULL, *visit, *visitNext;     // for multi-source BFS, allocated when first used
+    vector<VertexID> batchFrontier, batchNxtFrontier, batchTouched;
+    SearchContext(const VertexID& n);
+    ~SearchContext();
+    void newSearch();
 };
 
 // storage structure for DAG 
@@ -30,27 +93,80 @@ class Graph{
     public:
         // graph infos
         VertexID VN;
-        EdgeID EN;
-        PerNeighbor* neighbors;
+        EdgeID EN, adjEN;
+        CSRneighbors in, out;
         LabelID labelNum;
 
-        // read in graph
+        // vertices relabeled for locality, query endpoints are translated by raw2new
+        bool reordered = false;
+        VertexID *raw2new, *new2raw;
+        inline VertexID toNewId(const VertexID& v) const { return reordered ? raw2new[v] : v; }
+
+        // hop order for building 2-hop index by hopOrderStrategy, where "scc" needs the SCC (DAG vertex) of each vertex
+        vector<VertexID> getHopRanking(const VertexID* sccIds=NULL);
+
+        // vertices in a file of one raw vertex id per line (e.g., terminals), as new ids, exit if a vertex does not exist
+        // or appears more than once
+        vector<VertexID> readVertexFile(const string& filename, const string& name);
+
+        // neighbors with parallel edges collapsed, only built when collapseParallelEdges is set
+        bool collapsed = false;
+        EdgeID maskedEN = 0;
+        MaskedNeighbors maskedIn, maskedOut;
+
+        // read in graph, either in text format or in binary format
         Graph(const string& filename);
         ~Graph();
 
-        // online label constrained BFS
+        // snapshot of base graph with edges (in raw ids) added, sharing the vertex ids of base
+        Graph(const Graph& base, const vector<PerEdge>& addedEdges);
+
+        // dump graph in binary format, which can be loaded via mmap
+        void writeBinary(const string& filename);
+        double getGraphSizeInBytes();
+        unsigned long long getChecksum();
+
+        // online label constrained BFS, searches only modify the given context, or the default context if it is NULL,
+        // so that threads with their own contexts can search the same graph concurrently
         void initializeLCRsearch();
-        bool LCRsearch(const VertexID& s, const VertexID& t, const LabelSet& labelSet);
-        bool LCRsearch(const VertexID& s, const VertexID& t, const vector<LabelID>& lls);
+        SearchContext* newSearchContext() const;
+        bool LCRsearch(const VertexID& s, const VertexID& t, const LabelSet& labelSet, SearchContext* ctx=NULL) const;
+        bool LCRsearch(const VertexID& s, const VertexID& t, const vector<LabelID>& lls, SearchContext* ctx=NULL) const;
+
+        // online label constrained bidirectional BFS, expanding the smaller frontier level by level
+        bool biLCRsearch(const VertexID& s, const VertexID& t, const LabelSet& labelSet, SearchContext* ctx=NULL) const;
+        bool biLCRsearch(const VertexID& s, const VertexID& t, const vector<LabelID>& lls, SearchContext* ctx=NULL) const;
+
+        // direction-optimizing label constrained BFS, used by LCRsearch when directionOptimizing is set
+        bool doLCRsearch(const VertexID& s, const VertexID& t, const LabelSet& labelSet, SearchContext* ctx=NULL) const;
+        bool doLCRsearch(const VertexID& s, const VertexID& t, const vector<LabelID>& lls, SearchContext* ctx=NULL) const;
+
+        // multi-source label constrained BFS, answering queries sharing the same label set together
+        void LCRsearchBatch(const vector<VertexID>& S, const vector<VertexID>& T, const LabelSet& labelSet, vector<bool>& answers, SearchContext* ctx=NULL) const;
+        void LCRsearchBatch(const vector<VertexID>& S, const vector<VertexID>& T, const vector<LabelID>& lls, vector<bool>& answers, SearchContext* ctx=NULL) const;
+        void LCRsearchBatch(const vector<PerQuery>& queries, bool largeLabelSet, vector<bool>& answers, SearchContext* ctx=NULL) const;
 
     private:
         unordered_set<LabelID> labels;
 
+        // for loading graph
+        void loadText(const string& filename);
+        bool loadBinary(const string& filename);
+        void collapse();
+        void reorder(const string& strategy);
+        vector<VertexID> getRCMorder();
+        vector<double> getBetweennessScores();
+        vector<VertexID> readHopOrderFile(const string& filename);
+        void *mappedFile = NULL;
+        size_t mappedSize = 0;
+
         // for online label constrained BFS
-        VertexID offset=1;
-        VertexID queueBegin=0, queueEnd=0;
-        VertexID *visited, *Q; 
-        bool initialized = false;
+        SearchContext* defaultContext = NULL;
+        bool expandLevel(const CSRneighbors& adj, const MaskedNeighbors& masked, VertexID* q, VertexID& qBegin, VertexID& qEnd, VertexID* mine, const VertexID* other, const VertexID& offset, const LabelSet& labelSet) const;
+        bool expandLevel(const CSRneighbors& adj, VertexID* q, VertexID& qBegin, VertexID& qEnd, VertexID* mine, const VertexID* other, const VertexID& offset, const vector<LabelID>& lls) const;
+        bool directionSearch(const VertexID& s, const VertexID& t, const LabelSet& labelSet, const vector<LabelID>* lls, SearchContext& c) const;
+        bool hasParentInFrontier(const VertexID& v, const unsigned long long* inFrontier, const LabelSet& labelSet, const vector<LabelID>* lls) const;
+        void multiSourceSearch(const VertexID* S, const VertexID* T, unsigned int n, const LabelSet& labelSet, const vector<LabelID>* lls, vector<bool>& answers, size_t ansOffset, SearchContext& c) const;
 };
 
 #endif
\ No newline at end of file
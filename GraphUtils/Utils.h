@@ -22,6 +22,7 @@ C++ 11
 #include <queue>
 #include <vector>
 #include <set>
+#include <map>
 #include <unordered_map>
 #include <unordered_set>
 
@@ -29,6 +30,22 @@ C++ 11
 #include <sys/time.h>
 #include <random>
 
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+#include <thread>
+#include <atomic>
+#include <mutex>
+
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
 using namespace std;
 string graphFilename;
 
@@ -61,9 +78,122 @@ bool cmpByFirstElement(pair<VertexID, LabelSet> a, pair<VertexID, LabelSet> b) {
  */
 struct IndexNode {
     vector<pair<VertexID, LabelSet>> inHops, outHops;
-    VertexID raw2DAG;
 };
 
+// add entry (order, ls) to a hop list sorted by hop order, where entries of the current hop are appended
+// during building, while entries of earlier hops are inserted in place by edge insertions
+inline void addHopEntry(vector<pair<VertexID, LabelSet>>& hops, const VertexID& order, const LabelSet& ls) {
+    if (hops.empty() || hops.back().first<=order)
+        hops.emplace_back(order, ls);
+    else
+        hops.insert(upper_bound(hops.begin(), hops.end(), make_pair(order, ~LabelSet(0))), make_pair(order, ls));
+}
+
+// whether a hop list has an entry (order, x) with x contained in ls
+inline bool hasHopEntry(const vector<pair<VertexID, LabelSet>>& hops, const VertexID& order, const LabelSet& ls) {
+    auto iter = hops.rbegin();
+    if (iter!=hops.rend() && iter->first>order)
+        iter = vector<pair<VertexID, LabelSet>>::const_reverse_iterator(upper_bound(hops.begin(), hops.end(), make_pair(order, ~LabelSet(0))));
+    while (iter!=hops.rend() && iter->first==order) {
+        if (isSubset(iter->second, ls))
+            return true;
+        ++iter;
+    }
+    return false;
+}
+
+// end of entries with hop order no larger than order in a hop list sorted by hop order
+inline const pair<VertexID, LabelSet>* hopsEndAt(const vector<pair<VertexID, LabelSet>>& hops, const VertexID& order) {
+    return hops.data() + (upper_bound(hops.begin(), hops.end(), make_pair(order, ~LabelSet(0))) - hops.begin());
+}
+
+// number of entries in hop lists of n index nodes
+inline size_t getHopEntryCnt(const IndexNode* nodes, const VertexID& n) {
+    size_t cnt = 0;
+    for (VertexID v=0; v<n; ++v)
+        cnt += nodes[v].inHops.size() + nodes[v].outHops.size();
+    return cnt;
+}
+
+
+/*
+ * for storing index after building, hop lists of all vertices are packed into one array in CSR form,
+ * i.e., hops of vertex v are entries[offsets[v]], ..., entries[offsets[v+1]-1]
+ */
+struct PackedHops {
+    VertexID VN = 0;
+    size_t* offsets = NULL;
+    pair<VertexID, LabelSet>* entries = NULL;
+
+    // pack inHops or outHops of index nodes, each hop list is freed once copied to keep peak memory low
+    void pack(IndexNode* nodes, const VertexID& n, bool in) {
+        VN = n;
+        offsets = new size_t[VN+1];
+        offsets[0] = 0;
+        for (VertexID v=0; v<VN; ++v)
+            offsets[v+1] = offsets[v] + (in ? nodes[v].inHops.size() : nodes[v].outHops.size());
+        entries = new pair<VertexID, LabelSet>[offsets[VN]];
+        for (VertexID v=0; v<VN; ++v) {
+            vector<pair<VertexID, LabelSet>> tmp;
+            (in ? nodes[v].inHops : nodes[v].outHops).swap(tmp);
+            copy(tmp.begin(), tmp.end(), entries+offsets[v]);
+        }
+    }
+
+    // copy hop lists back to index nodes, e.g., for inserting entries
+    void unpack(IndexNode* nodes, bool in) const {
+        for (VertexID v=0; v<VN; ++v)
+            (in ? nodes[v].inHops : nodes[v].outHops).assign(begin(v), end(v));
+    }
+
+    inline const pair<VertexID, LabelSet>* begin(const VertexID& v) const {
+        return entries+offsets[v];
+    }
+    inline const pair<VertexID, LabelSet>* end(const VertexID& v) const {
+        return entries+offsets[v+1];
+    }
+    inline size_t entryCnt() const {
+        return offsets ? offsets[VN] : 0;
+    }
+    inline size_t sizeInBytes() const {
+        return offsets ? sizeof(size_t)*(VN+1) + sizeof(pair<VertexID, LabelSet>)*offsets[VN] : 0;
+    }
+
+    void freeMemory() {
+        delete[] offsets;
+        delete[] entries;
+        offsets = NULL;
+        entries = NULL;
+    }
+};
+
+
+// return freed heap memory to the OS, otherwise many small freed blocks (e.g., hop lists) stay resident
+inline void releaseFreeHeapMemory() {
+#ifdef __GLIBC__
+    malloc_trim(0);
+#endif
+}
+
+
+
+/*
+ * 64-bit checksum of a byte array for detecting corrupted files, where h is the checksum of preceding arrays
+ */
+inline unsigned long long checksum64(const void* data, const size_t& n, unsigned long long h=0x84222325cbf29ce4ULL) {
+    const char* p = (const char*)data;
+    size_t i = 0;
+    for (; i+8<=n; i+=8) {
+        unsigned long long w;
+        memcpy(&w, p+i, 8);
+        h = (h^w) * 0x100000001b3ULL;
+        h ^= h>>29;
+    }
+    for (; i<n; ++i)
+        h = (h^(unsigned char)p[i]) * 0x100000001b3ULL;
+    return h ^ n;
+}
+
 
 
 /* 
@@ -77,8 +207,141 @@ inline double getElapsedTimeInMs() {
     return 1000.0 * (clock()-startClock) / CLOCKS_PER_SEC;
 }
 
+// wall-clock time, for tasks running on multiple threads
+double startWallClock;
+inline double getWallTimeInMs() {
+    timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec*1000.0 + tv.tv_usec/1000.0;
+}
+inline void startRecordWallTime() {
+    startWallClock = getWallTimeInMs();
+}
+inline double getElapsedWallTimeInMs() {
+    return getWallTimeInMs()-startWallClock;
+}
+
+
+
+/*
+ * for counting hardware cache misses of this process (including threads created later)
+ * -1 is returned if hardware counters are not available, e.g., in virtual machines
+ */
+int cacheMissFd = -2;
+inline void startCountCacheMisses() {
+    if (cacheMissFd==-2) {
+        perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.size = sizeof(attr);
+        attr.config = PERF_COUNT_HW_CACHE_MISSES;
+        attr.disabled = 1;
+        attr.inherit = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        cacheMissFd = syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+    }
+    if (cacheMissFd>=0) {
+        ioctl(cacheMissFd, PERF_EVENT_IOC_RESET, 0);
+        ioctl(cacheMissFd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+}
+inline long long getCacheMisses() {
+    long long cnt = -1;
+    if (cacheMissFd>=0) {
+        ioctl(cacheMissFd, PERF_EVENT_IOC_DISABLE, 0);
+        if (read(cacheMissFd, &cnt, sizeof(cnt))!=sizeof(cnt))
+            cnt = -1;
+    }
+    return cnt;
+}
+inline string cacheMissesToString(const long long& cnt) {
+    return cnt<0 ? "n/a" : to_string(cnt);
+}
+
 
 
+/*
+ * for running tasks on multiple threads
+ */
+inline unsigned int getThreadNum() {
+    if (threadNum>0)
+        return threadNum;
+    return max(thread::hardware_concurrency(), 1u);
+}
+
+// run func(threadId) on threads [0, num), and wait until all of them finish
+template<typename Func>
+void runInParallel(const unsigned int& num, const Func& func) {
+    vector<thread> threads;
+    for (unsigned int i=1; i<num; ++i)
+        threads.emplace_back(func, i);
+    func(0);
+    for (thread& t : threads)
+        t.join();
+}
+
+
+// statistics of one thread in runWithWorkStealing
+struct WorkerStats {
+    size_t taskCnt = 0, stolenCnt = 0;
+    double busyTime = 0;
+};
+
+// run func(threadId, i) for each i in [0, n) on num threads, tasks are split evenly into per-thread ranges
+// taken chunk by chunk, and a thread having finished its own range steals chunks from the other ranges
+#define WORK_CHUNK_SIZE 64
+template<typename Func>
+vector<WorkerStats> runWithWorkStealing(const size_t& n, const unsigned int& num, const Func& func) {
+
+    // each range cursor occupies its own cache line, avoiding false sharing between threads
+    struct Range {
+        atomic<size_t> next;
+        size_t end;
+        char padding[64];
+    };
+    vector<Range> ranges(num);
+    for (unsigned int i=0; i<num; ++i) {
+        ranges[i].next = n*i/num;
+        ranges[i].end = n*(i+1)/num;
+    }
+
+    vector<WorkerStats> stats(num);
+    runInParallel(num, [&](unsigned int tid) {
+        WorkerStats local;
+        double startTime = getWallTimeInMs();
+        for (unsigned int k=0; k<num; ++k) {
+            Range& range = ranges[(tid+k)%num];
+            while (true) {
+                size_t begin = range.next.fetch_add(WORK_CHUNK_SIZE);
+                if (begin>=range.end)
+                    break;
+                size_t end = min(begin+WORK_CHUNK_SIZE, range.end);
+                for (size_t i=begin; i<end; ++i)
+                    func(tid, i);
+                local.taskCnt += end-begin;
+                if (k>0)
+                    local.stolenCnt += end-begin;
+            }
+        }
+        local.busyTime = getWallTimeInMs()-startTime;
+        stats[tid] = local;
+    });
+    return stats;
+}
+
+// print tasks and busy time of each thread, as well as load balance, i.e., max busy time over average
+inline void printWorkerStats(const vector<WorkerStats>& stats) {
+    double maxTime = 0, sumTime = 0;
+    for (unsigned int i=0; i<stats.size(); ++i) {
+        printf("- Thread %u: %zu tasks (%zu stolen), busy time: %.2fms\n", i, stats[i].taskCnt, stats[i].stolenCnt, stats[i].busyTime);
+        maxTime = max(maxTime, stats[i].busyTime);
+        sumTime += stats[i].busyTime;
+    }
+    if (sumTime>0)
+        printf("- Load balance (max/avg busy time): %.3f\n", maxTime*stats.size()/sumTime);
+}
+
 /*
  * Returns the number of labels in label set, 
  * e.g. if ls = {a, b} then this method returns 2
@@ -199,6 +462,37 @@ vector<PerQuery> loadQueryFile(const string& queryFileName, bool largeLabelSet)
 
 
 
+/*
+ * load edges to insert into the graph, each line is "src dst label"
+ */
+struct PerEdge {
+    VertexID src, dst;
+    LabelID label;
+    PerEdge(VertexID a, VertexID b, LabelID c): src(a), dst(b), label(c) {}
+};
+
+vector<PerEdge> loadEdgeFile(const string& edgeFileName) {
+    vector<PerEdge> edges;
+    ifstream edgeFile(edgeFileName);
+    if (!edgeFile.is_open()) {
+        cerr<<"! Error! Cannot open "<<edgeFileName<<endl;
+        exit(-1);
+    }
+
+    printf("Loading edge file: %s ...\n", edgeFileName.c_str());
+    startRecordTime();
+    VertexID s, t;
+    LabelID label;
+    while (edgeFile >> s >> t >> label)
+        edges.emplace_back(s, t, label);
+    edgeFile.close();
+
+    printf("- Finished, %d edges loaded. Time cost: %.2fms\n", int(edges.size()), getElapsedTimeInMs());
+    return edges;
+}
+
+
+
 /*
  * get current time string for writing logs, e.g. "2022-08-30 15:00"
  */
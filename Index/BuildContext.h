@@ -0,0 +1,221 @@
+/*
+LCR - Build Context
+Author: Yuzheng Cai
+2022-10-27
+------------------------------
+C++ 11
+Scratch state of pruned BFS in building 2-hop index, so that hops can be processed by several threads
+*/
+
+#ifndef BUILDCONTEXT_H
+#define BUILDCONTEXT_H
+#include "../GraphUtils/Utils.h"
+
+
+// hops are processed in batches of consecutive orders, the next batch has min(order/PARALLEL_BATCH_RATIO,
+// threads*PARALLEL_BATCH_HOPS) hops, so that top hops generating most entries are processed almost one by one
+#define PARALLEL_BATCH_RATIO 8
+#define PARALLEL_BATCH_HOPS 64
+
+// initial slots (log2) of the table of pairs visited in a level of pruned BFS
+#define SEEN_TABLE_BITS 10
+
+
+// each thread processing hops owns its own context, where entries of the BFS being run are buffered
+// per vertex (unless buffered is false, i.e., added to hop lists directly), and added to hop lists
+// after the batch, so that BFS of a batch only reads hop lists of earlier batches
+struct BuildContext {
+    vector<pair<VertexID, LabelSet>> frontier, nxtFrontier;
+    bool buffered = false;
+
+    // sparse set of vertices with buffered entries, v is in it iff slots[v]<used and slotIds[slots[v]]==v
+    VertexID* slots = NULL;
+    VertexID used = 0;
+    vector<VertexID> slotIds;
+    vector<vector<LabelSet>> slotLabels;
+
+    // hop list of the end of the current hop's DOR chain (the root) copied into rootHops, indexed by hop order in a
+    // dense table, where rootPos[h]-1 is the position of the first entry of hop h (0 if none), and vertices on the
+    // chain (onChain), loaded once per BFS so that pruning checks only scan hop lists of visited vertices
+    VertexID* rootPos = NULL;
+    vector<pair<VertexID, LabelSet>> rootHops;
+    bool* onChain = NULL;
+    vector<VertexID> chain;
+    VertexID chainEnd = 0;
+
+    // (vertex, label set) pairs visited in the current level of the BFS, kept in an open addressing table of the
+    // first 2^seenBits slots of seen, where slots of earlier levels have older epochs, so that pairs dominated by a
+    // visited pair are skipped before pruning checks (unless dedup is false), the table starts small in each level
+    struct SeenPair {
+        unsigned int epoch;
+        VertexID v;
+        LabelSet ls;
+    };
+    bool dedup = false;
+    unsigned int epoch = 0, seenBits = 0;
+    vector<SeenPair> seen, moved;
+    size_t seenCnt = 0;
+
+    // visited pairs, skipped pairs, pruning checks, and pairs pushed into frontiers of all BFS of the context
+    unsigned long long visitCnt = 0, dominatedCnt = 0, checkCnt = 0, pushCnt = 0;
+
+    BuildContext() {}
+    BuildContext(const VertexID& n, bool dedupPairs) {
+        buffered = true;
+        slots = new VertexID[n]();
+        rootPos = new VertexID[n]();
+        onChain = new bool[n]();
+        dedup = dedupPairs;
+        if (dedup) {
+            seenBits = SEEN_TABLE_BITS;
+            seen.resize(size_t(1)<<seenBits, {0, 0, 0});
+        }
+    }
+    ~BuildContext() {
+        if (slots) {
+            delete[] slots;
+            delete[] rootPos;
+            delete[] onChain;
+        }
+    }
+
+    inline void newSearch() {
+        used = 0;
+        newLevel();
+    }
+
+    // each level of the BFS has label sets of the same size, so visited pairs are forgotten per level
+    inline void newLevel() {
+        if (dedup==false)
+            return;
+        seenCnt = 0;
+        seenBits = SEEN_TABLE_BITS;
+        if (++epoch==0) {
+            for (SeenPair& x : seen)
+                x.epoch = 0;
+            epoch = 1;
+        }
+    }
+
+    // whether (v, ls') is visited in this level for some ls' contained in ls, otherwise (v, ls) is visited, where label
+    // sets of a level have the same size, i.e., ls'=ls, and the minimal antichain of visited label sets of v is all
+    // distinct ones
+    inline bool isDominated(const VertexID& v, const LabelSet& ls) {
+        ++visitCnt;
+        if (dedup==false)
+            return false;
+        if (2*(seenCnt+1)>(size_t(1)<<seenBits))
+            growSeen();
+        const size_t mask = (size_t(1)<<seenBits)-1;
+        for (size_t h=seenSlot(v, ls); ; h=(h+1)&mask) {
+            SeenPair& x = seen[h];
+            if (x.epoch!=epoch) {
+                x = {epoch, v, ls};
+                ++seenCnt;
+                return false;
+            }
+            if (x.v==v && x.ls==ls) {
+                ++dominatedCnt;
+                return true;
+            }
+        }
+    }
+    inline size_t seenSlot(const VertexID& v, const LabelSet& ls) const {
+        return ((((unsigned long long)v)<<32|ls)*0x9E3779B97F4A7C15ULL)>>(64-seenBits);
+    }
+
+    // double the table when half of it is used, pairs of the current level are moved
+    void growSeen() {
+        const size_t oldSize = size_t(1)<<seenBits;
+        moved.clear();
+        for (size_t h=0; h<oldSize; ++h)
+            if (seen[h].epoch==epoch) {
+                moved.emplace_back(seen[h]);
+                seen[h].epoch = 0;
+            }
+        ++seenBits;
+        if (seen.size()<2*oldSize)
+            seen.resize(2*oldSize, {0, 0, 0});
+        const size_t mask = 2*oldSize-1;
+        for (const SeenPair& x : moved) {
+            size_t h = seenSlot(x.v, x.ls);
+            while (seen[h].epoch==epoch)
+                h = (h+1)&mask;
+            seen[h] = x;
+        }
+    }
+
+    // whether v has a buffered entry with label set contained in ls
+    inline bool hasEntry(const VertexID& v, const LabelSet& ls) const {
+        const VertexID& slot = slots[v];
+        if (slot>=used || slotIds[slot]!=v)
+            return false;
+        for (const LabelSet& x : slotLabels[slot])
+            if (isSubset(x, ls))
+                return true;
+        return false;
+    }
+
+    inline void addEntry(const VertexID& v, const LabelSet& ls) {
+        VertexID slot = slots[v];
+        if (slot>=used || slotIds[slot]!=v) {
+            slot = slots[v] = used++;
+            if (slot==slotIds.size()) {
+                slotIds.emplace_back(v);
+                slotLabels.emplace_back();
+            } else {
+                slotIds[slot] = v;
+                slotLabels[slot].clear();
+            }
+        }
+        slotLabels[slot].emplace_back(ls);
+    }
+
+    // load the root after the chain is added, and unload the previous root
+    void loadRoot(const vector<pair<VertexID, LabelSet>>& hops) {
+        for (const pair<VertexID, LabelSet>& e : rootHops)
+            rootPos[e.first] = 0;
+        rootHops.assign(hops.begin(), hops.end());
+        for (VertexID i=rootHops.size(); i>0; --i)
+            rootPos[rootHops[i-1].first] = i;
+    }
+    inline void addToChain(const VertexID& v) {
+        onChain[v] = true;
+        chain.emplace_back(v);
+    }
+    inline void clearChain() {
+        for (const VertexID& v : chain)
+            onChain[v] = false;
+        chain.clear();
+    }
+
+    // whether the root and a vertex with hop list [a, aEnd) share a hop, whose entries have label sets contained in ls
+    inline bool intersectRoot(const pair<VertexID, LabelSet>* a, const pair<VertexID, LabelSet>* aEnd, const LabelSet& ls) const {
+        for (; a!=aEnd; ++a) {
+            if (isSubset(a->second, ls)==false || rootPos[a->first]==0)
+                continue;
+            for (VertexID r=rootPos[a->first]-1; r<rootHops.size() && rootHops[r].first==a->first; ++r)
+                if (isSubset(rootHops[r].second, ls))
+                    return true;
+        }
+        return false;
+    }
+
+    // move buffered entries of the BFS into (vertex, label set) pairs, in the order of being added
+    void flush(vector<pair<VertexID, LabelSet>>& entries) {
+        entries.clear();
+        for (VertexID slot=0; slot<used; ++slot)
+            for (const LabelSet& ls : slotLabels[slot])
+                entries.emplace_back(slotIds[slot], ls);
+        used = 0;
+    }
+};
+
+
+// entries of a hop found by its backward and forward BFS in a batch
+struct HopEntries {
+    vector<pair<VertexID, LabelSet>> in, out;
+};
+
+
+#endif
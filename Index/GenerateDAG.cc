@@ -21,7 +21,7 @@ GenerateDAG::GenerateDAG(Graph* inputRawGraph, int* intVNreuse, VertexID* vidVNr
     rawGraph = inputRawGraph;
     rawVN = rawGraph->VN;
     rawEN = rawGraph->EN;
-    rawNeighbors = rawGraph->neighbors;
+    rawOut = rawGraph->out;
 
     DAGvisited = intVNreuse;                    // remember which vertex has been visited
     instack = boolVNreuse;                      // remember which vertex is in stack
@@ -53,13 +53,14 @@ GenerateDAG::GenerateDAG(Graph* inputRawGraph, int* intVNreuse, VertexID* vidVNr
         for (const VertexID& u : DAG2raw[i]) {
 
             // add all out-edges of u into i's out-edges
-            for (auto iter=rawNeighbors[u].out.begin(); iter!=rawNeighbors[u].out.end(); ++iter)
-                for (const VertexID& v : iter->second)
-                    if (raw2DAG[v]!=i)                      // if the edge doesn't point to i itself
-                        if (isInOutEdges[raw2DAG[v]] < offset) {
-                            isInOutEdges[raw2DAG[v]] = offset;
-                            outEdges[outEdgesEnd++] = raw2DAG[v];
-                        }
+            for (EdgeID e=rawOut.offsets[u]; e<rawOut.offsets[u+1]; ++e) {
+                const VertexID& v = rawOut.ids[e];
+                if (raw2DAG[v]!=i)                          // if the edge doesn't point to i itself
+                    if (isInOutEdges[raw2DAG[v]] < offset) {
+                        isInOutEdges[raw2DAG[v]] = offset;
+                        outEdges[outEdgesEnd++] = raw2DAG[v];
+                    }
+            }
         }
         
         // add to total edge number of DAG
@@ -96,16 +97,16 @@ void GenerateDAG::tarjan(VertexID u) {
     stk.push(u);
     instack[u] = true;
 
-    for (auto iter=rawNeighbors[u].out.begin(); iter!=rawNeighbors[u].out.end(); ++iter)
-        for (const VertexID& v : iter->second) {   
-            if (DAGvisited[v]==0) {                      // haven't been visited
-                tarjan(v);
-                LOW[u] = LOW[u]<LOW[v]?LOW[u]:LOW[v];   // LOW should be the smallest among its childs
-            } 
-            else if (instack[v]) {                       // find a cycle         
-                LOW[u] = LOW[u]<DFN[v]?LOW[u]:DFN[v];   // update LOW
-            }
+    for (EdgeID e=rawOut.offsets[u]; e<rawOut.offsets[u+1]; ++e) {
+        const VertexID& v = rawOut.ids[e];
+        if (DAGvisited[v]==0) {                          // haven't been visited
+            tarjan(v);
+            LOW[u] = LOW[u]<LOW[v]?LOW[u]:LOW[v];       // LOW should be the smallest among its childs
+        } 
+        else if (instack[v]) {                           // find a cycle         
+            LOW[u] = LOW[u]<DFN[v]?LOW[u]:DFN[v];       // update LOW
         }
+    }
     
     VertexID id;
     if (DFN[u]==LOW[u]) {                                // find a new SCC 
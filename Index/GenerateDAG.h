@@ -29,7 +29,7 @@ class GenerateDAG {
         Graph* rawGraph;
         VertexID rawVN;
         EdgeID rawEN;   
-        PerNeighbor* rawNeighbors;
+        CSRneighbors rawOut;
         bool generatedDAG = false;
 
         VertexID order;                         // traversal order of DFS
@@ -0,0 +1,200 @@
+/*
+LCR - Compressed Hop Lists
+Author: Yuzheng Cai
+2022-10-27
+------------------------------
+C++ 11
+Encoding packed hop lists into blocks, and decoding them on the fly for queries
+*/
+
+#ifndef HOPCOMPRESSION_CC
+#define HOPCOMPRESSION_CC
+#include "HopCompression.h"
+
+
+inline void writeVarint(vector<unsigned char>& buf, unsigned int x) {
+    while (x>=128) {
+        buf.push_back((unsigned char)(x|128));
+        x >>= 7;
+    }
+    buf.push_back((unsigned char)x);
+}
+
+
+inline unsigned int readVarint(const unsigned char*& p) {
+    unsigned int x = 0, shift = 0;
+    unsigned char c;
+    do {
+        c = *p++;
+        x |= (unsigned int)(c&127)<<shift;
+        shift += 7;
+    } while (c&128);
+    return x;
+}
+
+
+unsigned int getLabelWidth(const PackedHops& inHops, const PackedHops& outHops) {
+    LabelSet allLabels = 0;
+    for (size_t i=0; i<inHops.entryCnt(); ++i)
+        allLabels |= inHops.entries[i].second;
+    for (size_t i=0; i<outHops.entryCnt(); ++i)
+        allLabels |= outHops.entries[i].second;
+    unsigned int width = 1;
+    while (width<8*sizeof(LabelSet) && (allLabels>>width)!=0)
+        ++width;
+    return width;
+}
+
+
+void CompressedHops::compress(const PackedHops& packed, const unsigned int& width) {
+    VN = packed.VN;
+    labelWidth = width;
+    entryNum = packed.entryCnt();
+    offsets = new size_t[VN+1];
+    offsets[0] = 0;
+
+    vector<unsigned char> buf, block;
+    for (VertexID v=0; v<VN; ++v) {
+        const pair<VertexID, LabelSet>* i = packed.begin(v);
+        const pair<VertexID, LabelSet>* end = packed.end(v);
+        VertexID prevHop = 0;
+        while (i!=end) {
+
+            // encode at most COMPRESSED_BLOCK_GROUPS groups into a block
+            block.clear();
+            VertexID lastHop = prevHop;
+            for (int g=0; g<COMPRESSED_BLOCK_GROUPS && i!=end; ++g) {
+                const VertexID hopId = i->first;
+                const pair<VertexID, LabelSet>* j = i;
+                while (j!=end && j->first==hopId)
+                    ++j;
+                const unsigned int entryCnt = j-i;
+                writeVarint(block, (hopId-lastHop)<<1 | (entryCnt>1));
+                if (entryCnt>1)
+                    writeVarint(block, entryCnt-2);
+
+                // pack label sets in little endian bit order
+                unsigned long long bits = 0;
+                unsigned int bitCnt = 0;
+                for (; i!=j; ++i) {
+                    bits |= (unsigned long long)(i->second)<<bitCnt;
+                    bitCnt += labelWidth;
+                    while (bitCnt>=8) {
+                        block.push_back((unsigned char)bits);
+                        bits >>= 8;
+                        bitCnt -= 8;
+                    }
+                }
+                if (bitCnt>0)
+                    block.push_back((unsigned char)bits);
+                lastHop = hopId;
+            }
+
+            writeVarint(buf, lastHop-prevHop);
+            writeVarint(buf, block.size());
+            buf.insert(buf.end(), block.begin(), block.end());
+            prevHop = lastHop;
+        }
+        offsets[v+1] = buf.size();
+    }
+
+    bytes = new unsigned char[buf.size()+1];
+    copy(buf.begin(), buf.end(), bytes);
+}
+
+
+void CompressedHops::freeMemory() {
+    delete[] offsets;
+    delete[] bytes;
+    offsets = NULL;
+    bytes = NULL;
+}
+
+
+CompressedHopReader::CompressedHopReader(const CompressedHops& hops, const VertexID& v) {
+    p = blockEnd = hops.begin(v);
+    listEnd = hops.end(v);
+    width = hops.labelWidth;
+}
+
+
+inline void CompressedHopReader::readBlockHeader() {
+    blockLast = hop + readVarint(p);
+    const unsigned int blockBytes = readVarint(p);
+    blockEnd = p + blockBytes;
+}
+
+
+inline bool CompressedHopReader::next() {
+    if (p==blockEnd) {
+        if (p==listEnd)
+            return false;
+        readBlockHeader();
+    }
+    const unsigned int x = readVarint(p);
+    hop += x>>1;
+    entryCnt = (x&1) ? readVarint(p)+2 : 1;
+    labels = p;
+    p += (entryCnt*width+7)>>3;
+    return true;
+}
+
+
+inline bool CompressedHopReader::skipTo(const VertexID& target) {
+    while (true) {
+        if (p==blockEnd) {
+            if (p==listEnd)
+                return false;
+            readBlockHeader();
+        }
+        if (blockLast>=target)
+            break;
+        hop = blockLast;
+        p = blockEnd;
+    }
+    do {
+        next();
+    } while (hop<target);
+    return true;
+}
+
+
+inline bool CompressedHopReader::usable(const LabelSet& ls) const {
+    const unsigned char* q = labels;
+    const unsigned long long mask = (1ULL<<width)-1;
+    unsigned long long bits = 0;
+    unsigned int bitCnt = 0;
+    for (unsigned int i=0; i<entryCnt; ++i) {
+        while (bitCnt<width) {
+            bits |= (unsigned long long)(*q++)<<bitCnt;
+            bitCnt += 8;
+        }
+        const LabelSet x = (LabelSet)(bits&mask);
+        if (isSubset(x, ls))
+            return true;
+        bits >>= width;
+        bitCnt -= width;
+    }
+    return false;
+}
+
+
+bool intersectCompressedHops(CompressedHopReader a, CompressedHopReader b, const LabelSet& ls) {
+    if (a.next()==false || b.next()==false)
+        return false;
+    while (true) {
+        if (a.hop==b.hop) {
+            if (a.usable(ls) && b.usable(ls))
+                return true;
+            if (a.next()==false || b.next()==false)
+                return false;
+        } else if (a.hop<b.hop) {
+            if (a.skipTo(b.hop)==false)
+                return false;
+        } else if (b.skipTo(a.hop)==false)
+            return false;
+    }
+}
+
+
+#endif
@@ -0,0 +1,83 @@
+/*
+LCR - Compressed Hop Lists
+Author: Yuzheng Cai
+2022-10-27
+------------------------------
+C++ 11
+Hop lists with entries grouped by hop id, where hop ids are delta and varint coded, and label sets are bit-packed
+*/
+
+#ifndef HOPCOMPRESSION_H
+#define HOPCOMPRESSION_H
+#include "../GraphUtils/Utils.h"
+
+
+// number of groups (hop ids) per block, a block is skipped without decoding its groups if its last hop id is too small
+#define COMPRESSED_BLOCK_GROUPS 16
+
+
+/*
+ * hop list of vertex v is stored in bytes[offsets[v]], ..., bytes[offsets[v+1]-1] as a sequence of blocks
+ *   block header: varint(last hop id in block - previous hop id), varint(number of bytes of groups in block)
+ *   each group:   varint((hop id - previous hop id)<<1 | hasMultipleEntries), [varint(number of entries - 2)],
+ *                 label sets of entries, each in labelWidth bits, padded to whole bytes
+ * where previous hop id is the last hop id of previous group (or block), starting from 0
+ */
+struct CompressedHops {
+    VertexID VN = 0;
+    unsigned int labelWidth = 1;
+    size_t entryNum = 0;
+    size_t* offsets = NULL;
+    unsigned char* bytes = NULL;
+
+    void compress(const PackedHops& packed, const unsigned int& width);
+    void freeMemory();
+
+    inline const unsigned char* begin(const VertexID& v) const {
+        return bytes+offsets[v];
+    }
+    inline const unsigned char* end(const VertexID& v) const {
+        return bytes+offsets[v+1];
+    }
+    inline size_t entryCnt() const {
+        return entryNum;
+    }
+    inline size_t sizeInBytes() const {
+        return offsets ? sizeof(size_t)*(VN+1) + offsets[VN] : 0;
+    }
+};
+
+
+// number of bits for storing all label sets in packed hop lists
+unsigned int getLabelWidth(const PackedHops& inHops, const PackedHops& outHops);
+
+
+// decode groups of a compressed hop list one by one
+class CompressedHopReader {
+    public:
+        VertexID hop = 0;                               // hop id of current group
+
+        CompressedHopReader(const CompressedHops& hops, const VertexID& v);
+
+        // move to next group, return false if there is no more group
+        inline bool next();
+
+        // move to the first group with hop id no smaller than target, skipping whole blocks if possible
+        inline bool skipTo(const VertexID& target);
+
+        // whether some entry of current group has label set contained in ls
+        inline bool usable(const LabelSet& ls) const;
+
+    private:
+        const unsigned char *p, *blockEnd, *listEnd, *labels = NULL;
+        VertexID blockLast = 0;
+        unsigned int width, entryCnt = 0;
+        inline void readBlockHeader();
+};
+
+
+// whether outHops of s and inHops of t in compressed form share a hop with label sets contained in ls
+bool intersectCompressedHops(CompressedHopReader a, CompressedHopReader b, const LabelSet& ls);
+
+
+#endif
@@ -0,0 +1,1086 @@
+/*
+LCR - Hop Index
+Author: Yuzheng Cai
+2022-10-27
+------------------------------
+C++ 11
+Implementations shared by Index and IndexL
+*/
+
+#ifndef HOPINDEX_CC
+#define HOPINDEX_CC
+#include "HopIndex.h"
+
+
+template<typename IndexType>
+double HopIndex<IndexType>::buildIndex() {
+    if (builtIndex) {
+        cout << "! Index already exists" <<endl;
+        return 0;
+    }
+    index = new IndexNode[VN];
+    raw2DAG = new VertexID[VN];
+
+    // wall time and cache misses of the whole construction, for measuring locality
+    double buildStartWallTime = getWallTimeInMs();
+    startCountCacheMisses();
+
+    // memory reused by several subtasks
+    int* intVNreuse = new int[VN]();
+    VertexID* vidVNreuse1 = new VertexID[VN+1];
+    VertexID* vidVNreuse2 = new VertexID[VN];
+    bool* boolVNreuse = new bool[VN]();
+    
+    // build DAG for unreachable query filter (UQF)
+    cout<<"Start building DAG ..."<<endl;
+    startRecordTime();
+    GenerateDAG dag(graph, intVNreuse, vidVNreuse1, vidVNreuse2, boolVNreuse);
+    double genDAGtime = getElapsedTimeInMs();
+    cout<<"- Finished. DAG has "<<dag.DAGVM<<" vertices and "<<dag.DAGEN<<" edges, degree="<<(dag.DAGEN)/float(dag.DAGVM)<<". Time cost: "<<genDAGtime<<" ms"<<endl;
+
+    // obtain vertex id mapping from original graph to DAG
+    DAGVN = dag.DAGVM;
+    for (VertexID i=0; i<VN; ++i)
+        raw2DAG[i] = dag.raw2DAG[i];
+    dag.freeMemory();
+    
+    // generate unreachable query filter index (UQF)
+    cout<<"Start building unreachable query filter index ..."<<endl;
+    startRecordTime();
+    UQF UQFindex(&dag, vidVNreuse1, vidVNreuse2, boolVNreuse);
+    double UQFindexTime = getElapsedTimeInMs();
+    cout<<"- Finished. Time cost: "<<UQFindexTime<<" ms"<<endl;
+
+    // obtain unreachable query filter (UQF) index
+    UQForders = UQFindex.UQForders;
+    UQFindex.freeMemory();
+    delete[] dag.DAGneighbors;
+
+    // free unuseful memory reused by several subtasks
+    delete[] intVNreuse;
+    hopRank = vidVNreuse2;
+    delete[] vidVNreuse1;
+    delete[] boolVNreuse;
+
+    // build 2-hop index using degree-one reduction (DOR), in wall time since hops are processed by several threads
+    printf("Start building P2H+ index with degree-one reduction ...\n");
+    startRecordWallTime();
+    self().divideLabels();
+    build2hop();
+
+    // pack hop lists into contiguous arrays for online query, and free the per-vertex hop lists
+    inHops.pack(index, VN, true);
+    outHops.pack(index, VN, false);
+    delete[] index;
+    if (compressIndex)
+        compressHops();
+    releaseFreeHeapMemory();
+    double P2HindexTime = getElapsedWallTimeInMs();
+    printf("- Finished, time cost: %.2fms\n", P2HindexTime);
+
+    // return total time cost
+    long long buildCacheMisses = getCacheMisses();
+    printf("- Index built, wall time: %.2fms, cache misses: %s\n", getWallTimeInMs()-buildStartWallTime, cacheMissesToString(buildCacheMisses).c_str());
+    builtIndex = true;
+    defaultContext = newQueryContext();
+    return genDAGtime + UQFindexTime + P2HindexTime;
+}
+
+
+template<typename IndexType>
+void HopIndex<IndexType>::freeIndex() {
+    if (builtIndex) {
+        if (mappedFile) {
+            munmap(mappedFile, mappedSize);
+            mappedFile = NULL;
+            inHops = outHops = PackedHops();
+            cInHops = cOutHops = CompressedHops();
+            labeled = NULL;
+            raw2DAG = NULL;
+            UQForders = NULL;
+        } else {
+            inHops.freeMemory();
+            outHops.freeMemory();
+            cInHops.freeMemory();
+            cOutHops.freeMemory();
+            delete[] labeled;
+            labeled = NULL;
+            delete[] raw2DAG;
+            delete[] UQForders;
+        }
+        if (dynamicHops) {
+            delete[] index;
+            delete[] inNeighbors.added;
+            delete[] outNeighbors.added;
+            delete[] hopRank;
+            inNeighbors.added = outNeighbors.added = NULL;
+            hopRank = NULL;
+            vector<VertexID>().swap(allHops);
+        }
+        compressedHops = dynamicHops = staleUQF = false;
+        insertedEdgeCnt = 0;
+        delete defaultContext;
+        builtIndex = false;
+    }
+}
+
+
+template<typename IndexType>
+double HopIndex<IndexType>::runAllQueries(const vector<PerQuery>& queries) {
+    if (builtIndex==false) {
+        cout << "! Index does not exist" <<endl;
+        return 0;
+    }
+
+    // answer queries by multiple threads, or one by one
+    double queryTime;
+    if (parallelQueries)
+        queryTime = runQueriesInParallel(queries);
+    else {
+        printf("Start running %d queries ...\n", int(queries.size()));
+        double queryStartWallTime = getWallTimeInMs();
+        startCountCacheMisses();
+        startRecordTime();
+        for (size_t i=0; i<queries.size(); ++i) {
+            const PerQuery& q = queries[i];
+            if (self().query(q.s, q.t, getQueryLabels(q, (IndexType*)NULL))==q.ans)
+                continue;
+            printf("! Error in %d-th query: %d->%d, label set: %s. Answer should be %s\n", int(i), q.s, q.t, labelSetToString(getQueryLabels(q, (IndexType*)NULL)).c_str(), q.ans?"true":"false");
+        }
+
+        queryTime = getElapsedTimeInMs();
+        long long queryCacheMisses = getCacheMisses();
+        printf("- Finished, time cost: %.2fms, wall time: %.2fms, cache misses: %s\n", queryTime, getWallTimeInMs()-queryStartWallTime, cacheMissesToString(queryCacheMisses).c_str());
+    }
+
+    if (verifyQueries)
+        verifyQueryFile(queries);
+    return queryTime;
+}
+
+
+// check answers in query file by multi-source BFS on the graph
+template<typename IndexType>
+void HopIndex<IndexType>::verifyQueryFile(const vector<PerQuery>& queries) {
+    vector<bool> answers;
+    int wrongCnt = 0;
+    if (defaultContext->search==NULL)
+        defaultContext->search = graph->newSearchContext();
+    startRecordWallTime();
+    graph->LCRsearchBatch(queries, isLargeLabelSet((IndexType*)NULL), answers, defaultContext->search);
+    for (size_t i=0; i<queries.size(); ++i) {
+        const PerQuery& q = queries[i];
+        if (answers[i]==q.ans)
+            continue;
+        ++wrongCnt;
+        printf("! Error in query file, %d-th query: %d->%d, label set: %s. Answer should be %s\n", int(i), q.s, q.t, labelSetToString(getQueryLabels(q, (IndexType*)NULL)).c_str(), answers[i]?"true":"false");
+    }
+    printf("- Verified by multi-source BFS, wrong answers in query file: %d, wall time: %.2fms\n", wrongCnt, getElapsedWallTimeInMs());
+}
+
+
+// replace packed hop lists by compressed ones, and report the compression ratio
+template<typename IndexType>
+void HopIndex<IndexType>::compressHops() {
+    double packedSize = inHops.sizeInBytes() + outHops.sizeInBytes();
+    double startWallTime = getWallTimeInMs();
+    unsigned int width = getLabelWidth(inHops, outHops);
+    cInHops.compress(inHops, width);
+    cOutHops.compress(outHops, width);
+    inHops.freeMemory();
+    outHops.freeMemory();
+    compressedHops = true;
+    double compressedSize = cInHops.sizeInBytes() + cOutHops.sizeInBytes();
+    printf("- Compressed hop lists, label width: %u bits, size: %.2fMB -> %.2fMB, compression ratio: %.2fx, wall time: %.2fms\n", width, packedSize/1048576, compressedSize/1048576, packedSize/max(compressedSize, 1.0), getWallTimeInMs()-startWallTime);
+}
+
+
+template<typename IndexType>
+bool HopIndex<IndexType>::query2hop(const VertexID& s, const VertexID& t, const LabelSet& ls) const {
+    if (compressedHops)
+        return intersectCompressedHops(CompressedHopReader(cOutHops, s), CompressedHopReader(cInHops, t), ls);
+    if (dynamicHops)
+        return intersectHops(index[s].outHops, index[t].inHops, ls);
+    return intersectHops(outHops.begin(s), outHops.end(s), inHops.begin(t), inHops.end(t), ls);
+}
+
+
+// a context owned by the caller, for answering queries concurrently
+template<typename IndexType>
+QueryContext* HopIndex<IndexType>::newQueryContext() const {
+    return new QueryContext(VN);
+}
+
+
+// arrays in index file, where sizes of UQF index and hop lists are given by the header
+template<typename IndexType>
+IndexFileArrays HopIndex<IndexType>::getFileArrays(const IndexFileHeader& header, LabelID*& mapping) {
+    IndexFileArrays arrays = {{(char**)&raw2DAG, sizeof(VertexID)*size_t(VN)},
+                              {(char**)&UQForders, sizeof(UQFindexNode)*size_t(header.DAGVN)}};
+    if (header.compressed)
+        arrays.insert(arrays.end(), {{(char**)&cInHops.offsets, sizeof(size_t)*(size_t(VN)+1)},
+                                     {(char**)&cInHops.bytes, header.inHopSize},
+                                     {(char**)&cOutHops.offsets, sizeof(size_t)*(size_t(VN)+1)},
+                                     {(char**)&cOutHops.bytes, header.outHopSize}});
+    else
+        arrays.insert(arrays.end(), {{(char**)&inHops.offsets, sizeof(size_t)*(size_t(VN)+1)},
+                                     {(char**)&inHops.entries, sizeof(pair<VertexID, LabelSet>)*header.inHopSize},
+                                     {(char**)&outHops.offsets, sizeof(size_t)*(size_t(VN)+1)},
+                                     {(char**)&outHops.entries, sizeof(pair<VertexID, LabelSet>)*header.outHopSize}});
+    if (header.restricted)
+        arrays.emplace_back((char**)&labeled, sizeof(unsigned char)*size_t(VN));
+    if (header.largeLabelSet)
+        arrays.emplace_back((char**)&mapping, sizeof(LabelID)*size_t(labelNum));
+    return arrays;
+}
+
+
+template<typename IndexType>
+void HopIndex<IndexType>::saveIndex(const string& filename) {
+    if (builtIndex==false) {
+        cout << "! Index does not exist" <<endl;
+        return;
+    }
+    if (insertedEdgeCnt>0) {
+        cout << "! Index with inserted edges cannot be saved, since the graph file does not contain them" <<endl;
+        return;
+    }
+    startRecordWallTime();
+    IndexFileHeader header;
+    memset(&header, 0, sizeof(header));
+    header.largeLabelSet = isLargeLabelSet((IndexType*)NULL);
+    header.VN = VN;
+    header.DAGVN = DAGVN;
+    header.adjEN = graph->adjEN;
+    header.labelNum = labelNum;
+    header.graphChecksum = graph->getChecksum();
+    header.compressed = compressedHops;
+    if (compressedHops) {
+        header.labelWidth = cInHops.labelWidth;
+        header.inHopSize = cInHops.offsets[VN];
+        header.outHopSize = cOutHops.offsets[VN];
+    } else {
+        header.inHopSize = inHops.entryCnt();
+        header.outHopSize = outHops.entryCnt();
+    }
+    header.inEntryNum = compressedHops ? cInHops.entryCnt() : inHops.entryCnt();
+    header.outEntryNum = compressedHops ? cOutHops.entryCnt() : outHops.entryCnt();
+    header.hopRankingChecksum = hopRankingChecksum;
+    header.labelBudget = budget;
+    header.restricted = labeled!=NULL;
+    LabelID* mapping = NULL;
+    self().saveLabelMapping(header, mapping);
+    writeIndexFile(filename, header, getFileArrays(header, mapping));
+    printf("- Index saved to %s, wall time: %.2fms\n", filename.c_str(), getElapsedWallTimeInMs());
+}
+
+
+template<typename IndexType>
+double HopIndex<IndexType>::loadIndex(const string& filename) {
+    if (builtIndex) {
+        cout << "! Index already exists" <<endl;
+        return 0;
+    }
+    startRecordWallTime();
+    IndexFileHeader header;
+    if (readIndexFileHeader(filename, header)==false) {
+        printf("- No index file of version %d at %s\n", INDEX_FILE_VERSION, filename.c_str());
+        return -1;
+    }
+    if (header.largeLabelSet!=isLargeLabelSet((IndexType*)NULL) || header.VN!=VN || header.adjEN!=graph->adjEN || header.labelNum!=labelNum || header.graphChecksum!=graph->getChecksum()) {
+        printf("- Index file %s is built on a different graph\n", filename.c_str());
+        return -1;
+    }
+
+    // arrays are checked by checksum, and point into the mapped file
+    LabelID* mapping = NULL;
+    mappedFile = mapIndexFile(filename, header, getFileArrays(header, mapping), mappedSize);
+    if (mappedFile==NULL) {
+        printf("! Index file %s is truncated or corrupted\n", filename.c_str());
+        return -1;
+    }
+    DAGVN = header.DAGVN;
+    compressedHops = header.compressed;
+    inHops.VN = outHops.VN = cInHops.VN = cOutHops.VN = VN;
+    cInHops.labelWidth = cOutHops.labelWidth = header.labelWidth;
+    cInHops.entryNum = header.inEntryNum;
+    cOutHops.entryNum = header.outEntryNum;
+    hopRankingChecksum = header.hopRankingChecksum;
+    budget = header.labelBudget;
+    self().loadLabelMapping(header, mapping);
+    builtIndex = true;
+    defaultContext = newQueryContext();
+    double loadTime = getElapsedWallTimeInMs();
+    printf("- Index loaded from %s, %s hop lists, wall time: %.2fms\n", filename.c_str(), compressedHops?"compressed":"packed", loadTime);
+    return loadTime;
+}
+
+
+template<typename IndexType>
+void HopIndex<IndexType>::build2hop() {
+
+    // rank hops by hopOrderStrategy, SCCs are given by DAG vertices
+    allHops = graph->getHopRanking(raw2DAG);
+    hopRankingChecksum = checksum64(allHops.data(), sizeof(VertexID)*size_t(VN));
+    for (VertexID order=0; order<VN; ++order)
+        hopRank[allHops[order]] = order;
+    budget = labelBudget;
+    if (budget>0)
+        printf("- Label sets of entries have at most %u labels, queries with more labels fall back to search\n", budget);
+
+    // orders of hops to process, i.e., only hops between ends of DOR chains of terminals if the index is restricted
+    // to terminals, which keep their ranks
+    vector<VertexID> roots;
+    if (terminalFilename=="")
+        for (VertexID order=0; order<VN; ++order)
+            roots.emplace_back(order);
+    else
+        roots = restrictToTerminals();
+    const VertexID hopNum = roots.size();
+
+    // backward BFS (task 2i) and forward BFS (task 2i+1) of each hop in a batch are run by several threads,
+    // and pruned by entries of earlier batches and entries of the same BFS, so the index is exact, and it is
+    // the same as processing hops one by one if there is only one thread
+    unsigned int num = getThreadNum();
+    vector<BuildContext*> contexts(num);
+    for (unsigned int i=0; i<num; ++i)
+        contexts[i] = new BuildContext(VN, dedupFrontiers);
+    vector<HopEntries> batchEntries;
+    VertexID batchCnt = 0;
+    double startWallTime = getWallTimeInMs();
+    for (VertexID begin=0; begin<hopNum; ++batchCnt) {
+        const VertexID batchSize = num==1 ? 1 : max(min(begin/PARALLEL_BATCH_RATIO, num*PARALLEL_BATCH_HOPS), 1u);
+        const VertexID end = min(begin+batchSize, hopNum);
+        const unsigned int batchNum = min(num, 2*(end-begin));
+        if (batchEntries.size()<end-begin)
+            batchEntries.resize(end-begin);
+
+        atomic<VertexID> nextTask(0);
+        runInParallel(batchNum, [&](unsigned int tid) {
+            BuildContext& c = *contexts[tid];
+            for (VertexID task=nextTask++; task<2*(end-begin); task=nextTask++) {
+                const VertexID& order = roots[begin+task/2];
+                const VertexID& hopId = allHops[order];
+                c.newSearch();
+                loadRoot(hopId, task%2==0, c);
+                c.frontier.emplace_back(hopId, 0);
+                if (task%2==0) {
+                    while (!c.frontier.empty()) {
+                        exploreBackwardWithCurLabels(hopId, order, c);
+                        exploreBackwardPlusOneLabel(hopId, order, c);
+                    }
+                    c.flush(batchEntries[task/2].out);
+                } else {
+                    while (!c.frontier.empty()) {
+                        exploreForwardWithCurLabels(hopId, order, c);
+                        exploreForwardPlusOneLabel(hopId, order, c);
+                    }
+                    c.flush(batchEntries[task/2].in);
+                }
+            }
+        });
+
+        // add entries to hop lists in hop order, vertices are interleaved among threads
+        runInParallel(batchNum, [&](unsigned int tid) {
+            for (VertexID i=begin; i<end; ++i) {
+                const VertexID& order = roots[i];
+                const VertexID& hopId = allHops[order];
+                const HopEntries& entries = batchEntries[i-begin];
+                for (const pair<VertexID, LabelSet>& e : entries.out)
+                    if (e.first%batchNum==tid)
+                        index[e.first].outHops.emplace_back(order, e.second);
+                for (const pair<VertexID, LabelSet>& e : entries.in)
+                    if (e.first%batchNum==tid)
+                        index[e.first].inHops.emplace_back(order, e.second);
+                if (hopId%batchNum==tid) {
+                    if (inNeighbors.degree(hopId)>1)
+                        index[hopId].inHops.emplace_back(order, 0);
+                    if (outNeighbors.degree(hopId)>1)
+                        index[hopId].outHops.emplace_back(order, 0);
+                }
+            }
+        });
+        begin = end;
+    }
+    printf("- Processed %d hops in %d batches by %u threads, wall time: %.2fms\n", hopNum, batchCnt, num, getWallTimeInMs()-startWallTime);
+    unsigned long long visitCnt = 0, dominatedCnt = 0, checkCnt = 0, pushCnt = 0;
+    for (BuildContext* c : contexts) {
+        visitCnt += c->visitCnt;
+        dominatedCnt += c->dominatedCnt;
+        checkCnt += c->checkCnt;
+        pushCnt += c->pushCnt;
+    }
+    printf("- Visited %llu (vertex, label set) pairs, dominated in frontiers: %llu, pruning checks: %llu, pushed into frontiers: %llu\n", visitCnt, dominatedCnt, checkCnt, pushCnt);
+    if (removeRedundant)
+        removeRedundantEntries();
+    if (labeled)
+        dropUnlabeledHops();
+    
+    // free memory
+    delete[] hopRank;
+    hopRank = NULL;
+    vector<VertexID>().swap(allHops);
+    for (BuildContext* c : contexts)
+        delete c;
+}
+
+
+// end of the DOR chain from v following unique neighbors, i.e., the first vertex whose degree is not one, or VN if the
+// chain runs into a cycle
+template<typename IndexType>
+VertexID HopIndex<IndexType>::chainEnd(const IndexNeighbors& neighbors, VertexID v) const {
+    for (VertexID steps=0; neighbors.degree(v)==1; ++steps) {
+        if (steps==VN)
+            return VN;
+        v = neighbors.uniqueNeighbor(v);
+    }
+    return v;
+}
+
+
+// queries from (to) terminals are reduced to ends of their DOR chains, which keep out-hops (in-hops), and pruned BFS of a
+// hop only visits v on paths between them via vertices ranked below the hop, i.e., fromOutEnd[v]>order in backward BFS,
+// and toInEnd[v]>order in forward BFS, where vertices are added from the lowest ranked one, and fromOutEnd[v] (toInEnd[v])
+// is the order of the vertex whose addition makes v reachable from (reaching) an end via added vertices, return the orders
+// of hops reachable from and reaching ends this way, as other hops are never the highest ranked vertex on paths of a query
+// between terminals
+template<typename IndexType>
+vector<VertexID> HopIndex<IndexType>::restrictToTerminals() {
+    double startWallTime = getWallTimeInMs();
+    vector<VertexID> terminals = graph->readVertexFile(terminalFilename, "terminal file");
+    labeled = new unsigned char[VN]();
+    VertexID outCnt = 0, inCnt = 0;
+    for (const VertexID& v : terminals) {
+        const VertexID outEnd = chainEnd(outNeighbors, v), inEnd = chainEnd(inNeighbors, v);
+        if (outEnd<VN && (labeled[outEnd]&1)==0) {
+            labeled[outEnd] |= 1;
+            ++outCnt;
+        }
+        if (inEnd<VN && (labeled[inEnd]&2)==0) {
+            labeled[inEnd] |= 2;
+            ++inCnt;
+        }
+    }
+
+    // each vertex is reached at most once in each direction, so all additions take O(EN) time
+    vector<char> reached(VN, 0);
+    vector<VertexID> queue;
+    fromOutEnd.assign(VN, 0);
+    toInEnd.assign(VN, 0);
+    auto add = [&](const VertexID& order, const IndexNeighbors& backNeighbors, const IndexNeighbors& neighbors, const char& bit, vector<VertexID>& reach) {
+        const VertexID& u = allHops[order];
+        bool found = labeled[u]&bit;
+        for (EdgeID e=backNeighbors.offsets[u]; e<backNeighbors.offsets[u+1] && found==false; ++e)
+            found = reached[backNeighbors.ids[e]]&bit;
+        if (found==false)
+            return false;
+        reached[u] |= bit;
+        reach[u] = order;
+        queue.assign(1, u);
+        for (size_t i=0; i<queue.size(); ++i)
+            for (EdgeID e=neighbors.offsets[queue[i]]; e<neighbors.offsets[queue[i]+1]; ++e) {
+                const VertexID& w = neighbors.ids[e];
+                if (hopRank[w]>order && (reached[w]&bit)==0) {
+                    reached[w] |= bit;
+                    reach[w] = order;
+                    queue.emplace_back(w);
+                }
+            }
+        return true;
+    };
+    vector<VertexID> roots;
+    for (VertexID order=VN; order>0; --order) {
+        const bool fromOut = add(order-1, inNeighbors, outNeighbors, 1, fromOutEnd);
+        const bool toIn = add(order-1, outNeighbors, inNeighbors, 2, toInEnd);
+        if (fromOut && toIn)
+            roots.emplace_back(order-1);
+    }
+    reverse(roots.begin(), roots.end());
+    printf("- Restricted to %d terminals, %d vertices keep out-hops, %d vertices keep in-hops, %d hops between them, wall time: %.2fms\n",
+           int(terminals.size()), outCnt, inCnt, int(roots.size()), getWallTimeInMs()-startWallTime);
+    return roots;
+}
+
+
+// after building, hop lists of vertices other than the ends only pruned BFS of later hops, and are dropped
+template<typename IndexType>
+void HopIndex<IndexType>::dropUnlabeledHops() {
+    const size_t entryCnt = getHopEntryCnt(index, VN);
+    for (VertexID v=0; v<VN; ++v) {
+        if ((labeled[v]&1)==0)
+            vector<pair<VertexID, LabelSet>>().swap(index[v].outHops);
+        if ((labeled[v]&2)==0)
+            vector<pair<VertexID, LabelSet>>().swap(index[v].inHops);
+    }
+    vector<VertexID>().swap(fromOutEnd);
+    vector<VertexID>().swap(toInEnd);
+    printf("- Dropped hop lists of vertices other than ends of DOR chains of terminals, entries: %zu -> %zu\n", entryCnt, getHopEntryCnt(index, VN));
+}
+
+
+// remove entries implied by the others after building, i.e., entry (order, ls) of v is redundant if v has another
+// entry (order, x) with x contained in ls, or if v and the root of the hop (the end of its DOR chain) share a hop of
+// higher rank within ls, so that every query is still answered by entries of its highest ranked hop, which are never
+// redundant, all entries are checked against the full index before removing any of them
+template<typename IndexType>
+void HopIndex<IndexType>::removeRedundantEntries() {
+    double startWallTime = getWallTimeInMs();
+    const size_t entryCnt = getHopEntryCnt(index, VN);
+    unsigned int num = getThreadNum();
+
+    // roots of hops for backward BFS (inRoots) and forward BFS (outRoots)
+    vector<VertexID> inRoots(VN), outRoots(VN);
+    runInParallel(num, [&](unsigned int tid) {
+        for (VertexID order=tid; order<VN; order+=num) {
+            inRoots[order] = chainEnd(inNeighbors, allHops[order]);
+            outRoots[order] = chainEnd(outNeighbors, allHops[order]);
+        }
+    });
+
+    // positions of redundant entries in hop lists of each vertex, entries of the same hop are adjacent
+    vector<vector<VertexID>> redundantIn(VN), redundantOut(VN);
+    vector<size_t> dominatedCnt(num, 0), coveredCnt(num, 0);
+    auto findRedundant = [&](const vector<pair<VertexID, LabelSet>>& hops, const VertexID& v, bool in, vector<VertexID>& redundant, const unsigned int& tid) {
+        const IndexNeighbors& chainNeighbors = in ? outNeighbors : inNeighbors;
+        for (VertexID i=0, first=0; i<hops.size(); ++i) {
+            const VertexID& order = hops[i].first;
+            const LabelSet& ls = hops[i].second;
+            if (i>0 && hops[i-1].first!=order)
+                first = i;
+            bool dominated = false;
+            for (VertexID j=first; j<hops.size() && hops[j].first==order && dominated==false; ++j)
+                dominated = j!=i && isSubset(hops[j].second, ls) && (hops[j].second!=ls || j<i);
+            if (dominated) {
+                redundant.emplace_back(i);
+                ++dominatedCnt[tid];
+                continue;
+            }
+
+            // chain vertices reach the hop without passing its root, so their entries are kept
+            const VertexID root = in ? outRoots[order] : inRoots[order];
+            if (root==VN || root==v || (root!=allHops[order] && chainNeighbors.degree(v)==1))
+                continue;
+            const vector<pair<VertexID, LabelSet>>& rootHops = in ? index[root].outHops : index[root].inHops;
+            const pair<VertexID, LabelSet>* rootEnd = rootHops.data() + (lower_bound(rootHops.begin(), rootHops.end(), make_pair(order, LabelSet(0))) - rootHops.begin());
+            bool covered = in ? intersectHops(rootHops.data(), rootEnd, hops.data(), hops.data()+first, ls)
+                              : intersectHops(hops.data(), hops.data()+first, rootHops.data(), rootEnd, ls);
+            if (covered) {
+                redundant.emplace_back(i);
+                ++coveredCnt[tid];
+            }
+        }
+    };
+    runWithWorkStealing(VN, num, [&](unsigned int tid, size_t v) {
+        findRedundant(index[v].inHops, v, true, redundantIn[v], tid);
+        findRedundant(index[v].outHops, v, false, redundantOut[v], tid);
+    });
+
+    // remove them after all checks
+    auto removeEntries = [](vector<pair<VertexID, LabelSet>>& hops, const vector<VertexID>& redundant) {
+        VertexID cnt = 0;
+        for (VertexID i=0, r=0; i<hops.size(); ++i)
+            if (r<redundant.size() && redundant[r]==i)
+                ++r;
+            else
+                hops[cnt++] = hops[i];
+        hops.resize(cnt);
+    };
+    runInParallel(num, [&](unsigned int tid) {
+        for (VertexID v=tid; v<VN; v+=num) {
+            removeEntries(index[v].inHops, redundantIn[v]);
+            removeEntries(index[v].outHops, redundantOut[v]);
+        }
+    });
+
+    size_t dominated = 0, covered = 0;
+    for (unsigned int tid=0; tid<num; ++tid) {
+        dominated += dominatedCnt[tid];
+        covered += coveredCnt[tid];
+    }
+    printf("- Removed %zu of %zu entries (%zu dominated by entries of the same hop, %zu covered by higher ranked hops), %zu bytes, wall time: %.2fms\n",
+           dominated+covered, entryCnt, dominated, covered, sizeof(pair<VertexID, LabelSet>)*(dominated+covered), getWallTimeInMs()-startWallTime);
+}
+
+
+// walk the DOR chain of hopId (unique in-neighbors for backward BFS) once, and load the hop list of its end
+// into the dense table of the context
+template<typename IndexType>
+void HopIndex<IndexType>::loadRoot(const VertexID& hopId, bool backward, BuildContext& c) {
+    const IndexNeighbors& chainNeighbors = backward ? inNeighbors : outNeighbors;
+    c.clearChain();
+    VertexID cur = hopId;
+    while (chainNeighbors.degree(cur)==1) {
+        cur = chainNeighbors.uniqueNeighbor(cur);
+        if (c.onChain[cur])
+            break;
+        c.addToChain(cur);
+    }
+    c.chainEnd = cur;
+    c.loadRoot(backward ? index[cur].inHops : index[cur].outHops);
+}
+
+
+// add index entry for v if it is not pruned, and push v into the frontier
+template<typename IndexType>
+inline void HopIndex<IndexType>::visitBackward(const VertexID& hopId, const VertexID& order, const VertexID& v, const LabelSet& ls, vector<pair<VertexID, LabelSet>>& toFrontier, BuildContext& c) {
+    if (budget>0 && __builtin_popcount(ls)>budget)
+        return;
+    if (hopRank[v]<=order || (labeled && fromOutEnd[v]<=order) || c.isDominated(v, ls))
+        return;
+    ++c.checkCnt;
+    if (queryForIndexBackward(order, v, hopId, ls, c))
+        return;
+    if (outNeighbors.degree(v)!=1) {
+        if (c.buffered)
+            c.addEntry(v, ls);
+        else
+            addHopEntry(index[v].outHops, order, ls);
+    }
+    toFrontier.emplace_back(v, ls);
+    ++c.pushCnt;
+}
+
+
+template<typename IndexType>
+inline void HopIndex<IndexType>::visitForward(const VertexID& hopId, const VertexID& order, const VertexID& v, const LabelSet& ls, vector<pair<VertexID, LabelSet>>& toFrontier, BuildContext& c) {
+    if (budget>0 && __builtin_popcount(ls)>budget)
+        return;
+    if (hopRank[v]<=order || (labeled && toInEnd[v]<=order) || c.isDominated(v, ls))
+        return;
+    ++c.checkCnt;
+    if (queryForIndexForward(order, hopId, v, ls, c))
+        return;
+    if (inNeighbors.degree(v)!=1) {
+        if (c.buffered)
+            c.addEntry(v, ls);
+        else
+            addHopEntry(index[v].inHops, order, ls);
+    }
+    toFrontier.emplace_back(v, ls);
+    ++c.pushCnt;
+}
+
+
+// explore the current level of pruned BFS, i.e., neighbors via edges with labels in the label set of each frontier
+template<typename IndexType>
+void HopIndex<IndexType>::exploreBackwardWithCurLabels(const VertexID& hopId, const VertexID& order, BuildContext& c) {
+    VertexID curIdx = 0;
+    while (curIdx<c.frontier.size()) {
+        const VertexID u = c.frontier[curIdx].first;
+        const LabelSet ls = c.frontier[curIdx].second;
+        ++curIdx;
+        self().forEachInRun(u, [&](const VertexID* e, const VertexID* end, const LabelSet& labels) {
+            if (labels & ls)
+                for (; e!=end; ++e)
+                    visitBackward(hopId, order, *e, ls, c.frontier, c);
+        });
+    }
+}
+
+
+// move to the next level of pruned BFS, i.e., neighbors via edges with one more label
+template<typename IndexType>
+void HopIndex<IndexType>::exploreBackwardPlusOneLabel(const VertexID& hopId, const VertexID& order, BuildContext& c) {
+    VertexID curIdx = 0;
+    c.nxtFrontier.clear();
+    c.newLevel();
+    while (curIdx<c.frontier.size()) {
+        const VertexID& u = c.frontier[curIdx].first;
+        const LabelSet& ls = c.frontier[curIdx].second;
+        ++curIdx;
+        if (budget>0 && __builtin_popcount(ls)>=budget)
+            continue;
+        self().forEachInRun(u, [&](const VertexID* begin, const VertexID* end, const LabelSet& labels) {
+            for (LabelSet newLabels = labels & ~ls; newLabels; newLabels &= newLabels-1)
+                for (const VertexID* e=begin; e!=end; ++e)
+                    visitBackward(hopId, order, *e, ls | (newLabels & -newLabels), c.nxtFrontier, c);
+        });
+    }
+    c.frontier.swap(c.nxtFrontier);
+}
+
+
+template<typename IndexType>
+void HopIndex<IndexType>::exploreForwardWithCurLabels(const VertexID& hopId, const VertexID& order, BuildContext& c) {
+    VertexID curIdx = 0;
+    while (curIdx<c.frontier.size()) {
+        const VertexID u = c.frontier[curIdx].first;
+        const LabelSet ls = c.frontier[curIdx].second;
+        ++curIdx;
+        self().forEachOutRun(u, [&](const VertexID* e, const VertexID* end, const LabelSet& labels) {
+            if (labels & ls)
+                for (; e!=end; ++e)
+                    visitForward(hopId, order, *e, ls, c.frontier, c);
+        });
+    }
+}
+
+
+template<typename IndexType>
+void HopIndex<IndexType>::exploreForwardPlusOneLabel(const VertexID& hopId, const VertexID& order, BuildContext& c) {
+    VertexID curIdx = 0;
+    c.nxtFrontier.clear();
+    c.newLevel();
+    while (curIdx<c.frontier.size()) {
+        const VertexID& u = c.frontier[curIdx].first;
+        const LabelSet& ls = c.frontier[curIdx].second;
+        ++curIdx;
+        if (budget>0 && __builtin_popcount(ls)>=budget)
+            continue;
+        self().forEachOutRun(u, [&](const VertexID* begin, const VertexID* end, const LabelSet& labels) {
+            for (LabelSet newLabels = labels & ~ls; newLabels; newLabels &= newLabels-1)
+                for (const VertexID* e=begin; e!=end; ++e)
+                    visitForward(hopId, order, *e, ls | (newLabels & -newLabels), c.nxtFrontier, c);
+        });
+    }
+    c.frontier.swap(c.nxtFrontier);
+}
+
+
+template<typename IndexType>
+inline bool HopIndex<IndexType>::queryForIndexForward(const VertexID& order, const VertexID& hopId, const VertexID& v, const LabelSet& ls, const BuildContext& c) {
+
+    // entries of the current hop are buffered in the context when building
+    if (inNeighbors.degree(v)!=1 && (c.buffered ? c.hasEntry(v, ls) : hasHopEntry(index[v].inHops, order, ls)))
+        return true;
+
+    // the chain and hop list of its end are loaded into the context when building
+    VertexID cur = hopId;
+    if (c.buffered) {
+        if (c.onChain[v]) return false;
+        cur = c.chainEnd;
+    } else
+        while (outNeighbors.degree(cur)==1) {
+            cur = outNeighbors.uniqueNeighbor(cur);
+            if (cur==v) return false;
+        }
+    if (c.buffered)
+        return c.intersectRoot(index[v].inHops.data(), index[v].inHops.data()+index[v].inHops.size(), ls);
+
+    // query 2-hop index, where entries of later hops added by edge insertions are ignored as in building
+    if (resuming)
+        return intersectHops(index[cur].outHops.data(), hopsEndAt(index[cur].outHops, order), index[v].inHops.data(), hopsEndAt(index[v].inHops, order), ls);
+    return intersectHops(index[cur].outHops, index[v].inHops, ls);
+}
+
+
+template<typename IndexType>
+inline bool HopIndex<IndexType>::queryForIndexBackward(const VertexID& order, const VertexID& v, const VertexID& hopId, const LabelSet& ls, const BuildContext& c) {
+
+    // entries of the current hop are buffered in the context when building
+    if (outNeighbors.degree(v)!=1 && (c.buffered ? c.hasEntry(v, ls) : hasHopEntry(index[v].outHops, order, ls)))
+        return true;
+
+    // the chain and hop list of its end are loaded into the context when building
+    VertexID cur = hopId;
+    if (c.buffered) {
+        if (c.onChain[v]) return false;
+        cur = c.chainEnd;
+    } else
+        while (inNeighbors.degree(cur)==1) {
+            cur = inNeighbors.uniqueNeighbor(cur);
+            if (cur==v) return false;
+        }
+    if (c.buffered)
+        return c.intersectRoot(index[v].outHops.data(), index[v].outHops.data()+index[v].outHops.size(), ls);
+
+    // query 2-hop index, where entries of later hops added by edge insertions are ignored as in building
+    if (resuming)
+        return intersectHops(index[v].outHops.data(), hopsEndAt(index[v].outHops, order), index[cur].inHops.data(), hopsEndAt(index[cur].inHops, order), ls);
+    return intersectHops(index[v].outHops, index[cur].inHops, ls);
+}
+
+
+// switch to per-vertex hop lists and adjacency overlays before the first edge insertion
+template<typename IndexType>
+void HopIndex<IndexType>::prepareForUpdates() {
+    index = new IndexNode[VN];
+    inHops.unpack(index, true);
+    outHops.unpack(index, false);
+    if (mappedFile)
+        inHops = outHops = PackedHops();
+    else {
+        inHops.freeMemory();
+        outHops.freeMemory();
+    }
+    dynamicHops = true;
+
+    inNeighbors.added = new vector<pair<VertexID, LabelID>>[VN];
+    outNeighbors.added = new vector<pair<VertexID, LabelID>>[VN];
+
+    // the hop ranking only depends on the graph and the strategy, which must be the same as in building
+    allHops = graph->getHopRanking(raw2DAG);
+    if (checksum64(allHops.data(), sizeof(VertexID)*size_t(VN))!=hopRankingChecksum) {
+        cerr<<"! Error! Hop order by "<<hopOrderStrategy<<" differs from the order that the index is built with"<<endl;
+        exit(-1);
+    }
+    hopRank = new VertexID[VN];
+    for (VertexID order=0; order<VN; ++order)
+        hopRank[allHops[order]] = order;
+}
+
+
+// hops reaching v, i.e., v itself, vertices on its chain of unique in-neighbors, and in-hops of the chain end,
+// sorted by hop order
+template<typename IndexType>
+void HopIndex<IndexType>::collectInHops(const VertexID& v, vector<pair<VertexID, LabelSet>>& hops) {
+    hops.assign(1, make_pair(hopRank[v], LabelSet(0)));
+    int* visited = defaultContext->visited;
+    int offset = defaultContext->nextMark();
+    visited[v] = offset;
+    VertexID cur = v;
+    LabelSet ls = 0;
+    bool cycle = false;
+    while (inNeighbors.degree(cur)==1) {
+        ls |= self().labelBit(inNeighbors.uniqueLabel(cur));
+        cur = inNeighbors.uniqueNeighbor(cur);
+        if (visited[cur]==offset) {
+            cycle = true;
+            break;
+        }
+        visited[cur] = offset;
+        hops.emplace_back(hopRank[cur], ls);
+    }
+    if (cycle==false)
+        for (const pair<VertexID, LabelSet>& e : index[cur].inHops)
+            hops.emplace_back(e.first, e.second|ls);
+    sort(hops.begin(), hops.end());
+    hops.erase(unique(hops.begin(), hops.end()), hops.end());
+}
+
+
+// hops reachable from v, i.e., v itself, vertices on its chain of unique out-neighbors, and out-hops of the chain end,
+// sorted by hop order
+template<typename IndexType>
+void HopIndex<IndexType>::collectOutHops(const VertexID& v, vector<pair<VertexID, LabelSet>>& hops) {
+    hops.assign(1, make_pair(hopRank[v], LabelSet(0)));
+    int* visited = defaultContext->visited;
+    int offset = defaultContext->nextMark();
+    visited[v] = offset;
+    VertexID cur = v;
+    LabelSet ls = 0;
+    bool cycle = false;
+    while (outNeighbors.degree(cur)==1) {
+        ls |= self().labelBit(outNeighbors.uniqueLabel(cur));
+        cur = outNeighbors.uniqueNeighbor(cur);
+        if (visited[cur]==offset) {
+            cycle = true;
+            break;
+        }
+        visited[cur] = offset;
+        hops.emplace_back(hopRank[cur], ls);
+    }
+    if (cycle==false)
+        for (const pair<VertexID, LabelSet>& e : index[cur].outHops)
+            hops.emplace_back(e.first, e.second|ls);
+    sort(hops.begin(), hops.end());
+    hops.erase(unique(hops.begin(), hops.end()), hops.end());
+}
+
+
+// insert edge and resume pruned BFS of affected hops as in dynamic pruned landmark labeling, i.e., each hop reaching
+// s continues its forward BFS from t, and each hop reachable from t continues its backward BFS from s
+template<typename IndexType>
+bool HopIndex<IndexType>::insertEdge(const VertexID& rawS, const VertexID& rawT, const LabelID& label) {
+    if (builtIndex==false) {
+        cout << "! Index does not exist" <<endl;
+        return false;
+    }
+    if (compressedHops) {
+        cout << "! Compressed index cannot be updated" <<endl;
+        return false;
+    }
+    if (labeled) {
+        cout << "! Index restricted to terminals cannot be updated" <<endl;
+        return false;
+    }
+    if (rawS>=VN || rawT>=VN || label>=labelNum) {
+        printf("! Invalid edge %d->%d with label %d\n", rawS, rawT, label);
+        return false;
+    }
+    if (rawS==rawT)
+        return false;
+    const VertexID s = graph->toNewId(rawS), t = graph->toNewId(rawT);
+    if (dynamicHops==false)
+        prepareForUpdates();
+    if (outNeighbors.hasEdge(s, t, label))
+        return false;
+
+    // hops reaching s and reachable from t before insertion
+    vector<pair<VertexID, LabelSet>> sInHops, tOutHops, tmp;
+    collectInHops(s, sInHops);
+    collectOutHops(t, tOutHops);
+
+    // s and t leaving degree-one reduction store their hop lists derived from their chains
+    if (outNeighbors.degree(s)==1) {
+        collectOutHops(s, tmp);
+        index[s].outHops.swap(tmp);
+    }
+    if (inNeighbors.degree(t)==1) {
+        collectInHops(t, tmp);
+        index[t].inHops.swap(tmp);
+    }
+
+    outNeighbors.added[s].emplace_back(t, label);
+    inNeighbors.added[t].emplace_back(s, label);
+    ++insertedEdgeCnt;
+
+    // orders of UQF remain valid if they are consistent with the new edge, otherwise UQF is bypassed
+    const VertexID& sDAG = raw2DAG[s];
+    const VertexID& tDAG = raw2DAG[t];
+    if (sDAG!=tDAG && staleUQF==false) {
+        const UQFindexNode& nS = UQForders[sDAG];
+        const UQFindexNode& nT = UQForders[tDAG];
+        if ( nS.X>=nT.X || nS.Y>=nT.Y || nS.level>=nT.level || nS.H1>=nT.H1 || nS.H2>=nT.H2 )
+            staleUQF = true;
+    }
+
+    // resume BFS of affected hops in hop order, so that hop lists of earlier hops are complete when pruning later ones
+    resuming = true;
+    BuildContext& c = updateCtx;
+    const LabelSet newLabel = self().labelBit(label);
+    size_t i = 0, j = 0;
+    while (i<sInHops.size() || j<tOutHops.size()) {
+        const VertexID order = min(i<sInHops.size() ? sInHops[i].first : VN, j<tOutHops.size() ? tOutHops[j].first : VN);
+        const VertexID& hopId = allHops[order];
+
+        // backward BFS
+        for (; j<tOutHops.size() && tOutHops[j].first==order; ++j)
+            visitBackward(hopId, order, s, tOutHops[j].second | newLabel, c.frontier, c);
+        while (!c.frontier.empty()) {
+            exploreBackwardWithCurLabels(hopId, order, c);
+            exploreBackwardPlusOneLabel(hopId, order, c);
+        }
+
+        // forward BFS
+        for (; i<sInHops.size() && sInHops[i].first==order; ++i)
+            visitForward(hopId, order, t, sInHops[i].second | newLabel, c.frontier, c);
+        while (!c.frontier.empty()) {
+            exploreForwardWithCurLabels(hopId, order, c);
+            exploreForwardPlusOneLabel(hopId, order, c);
+        }
+    }
+    resuming = false;
+    return true;
+}
+
+
+// insert edges one by one, and compare the cost per insertion with rebuilding the index (if rebuildTime>=0),
+// queries are answered again and checked if verifyQueries is set
+template<typename IndexType>
+double HopIndex<IndexType>::runEdgeInsertions(const vector<PerEdge>& edges, const double& rebuildTime, const vector<PerQuery>& queries) {
+    if (builtIndex==false) {
+        cout << "! Index does not exist" <<endl;
+        return 0;
+    }
+    if (compressedHops) {
+        cout << "! Compressed index cannot be updated" <<endl;
+        return 0;
+    }
+    if (labeled) {
+        cout << "! Index restricted to terminals cannot be updated" <<endl;
+        return 0;
+    }
+    printf("Start inserting %d edges ...\n", int(edges.size()));
+    double entryCnt = getIndexEntryCnt();
+    vector<PerEdge> inserted;
+    startRecordWallTime();
+    for (const PerEdge& e : edges)
+        if (insertEdge(e.src, e.dst, e.label))
+            inserted.emplace_back(e);
+    double insertTime = getElapsedWallTimeInMs();
+    const int insertedCnt = inserted.size();
+    double throughput = edges.size()/max(insertTime, 1e-3)*1000;
+    printf("- Finished, inserted edges: %d, skipped edges: %d, new index entries: %.0f, UQF: %s, wall time: %.2fms, throughput: %.0f updates/s\n",
+           insertedCnt, int(edges.size())-insertedCnt, getIndexEntryCnt()-entryCnt, staleUQF?"bypassed":"valid", insertTime, throughput);
+    if (rebuildTime>=0)
+        printf("- Rebuilding index costs %.2fms, as much as %.0f updates\n", rebuildTime, rebuildTime/1000*throughput);
+
+    // answers of the updated index are checked against multi-source BFS on a snapshot of the graph with inserted edges
+    if (verifyQueries && queries.empty()==false) {
+        startRecordWallTime();
+        Graph snapshot(*graph, inserted);
+        vector<bool> answers;
+        SearchContext* searchCtx = snapshot.newSearchContext();
+        snapshot.LCRsearchBatch(queries, isLargeLabelSet((IndexType*)NULL), answers, searchCtx);
+        delete searchCtx;
+        int wrongCnt = 0, changedCnt = 0;
+        for (size_t i=0; i<queries.size(); ++i) {
+            const PerQuery& q = queries[i];
+            changedCnt += answers[i]!=q.ans;
+            if (self().query(q.s, q.t, getQueryLabels(q, (IndexType*)NULL))==answers[i])
+                continue;
+            ++wrongCnt;
+            printf("! Error after inserting edges, %d-th query: %d->%d, label set: %s. Answer should be %s\n", int(i), q.s, q.t, labelSetToString(getQueryLabels(q, (IndexType*)NULL)).c_str(), answers[i]?"true":"false");
+        }
+        printf("- Verified by multi-source BFS with inserted edges, wrong answers: %d, answers changed by inserted edges: %d, wall time: %.2fms\n", wrongCnt, changedCnt, getElapsedWallTimeInMs());
+    }
+    return insertTime;
+}
+
+
+template<typename IndexType>
+double HopIndex<IndexType>::getIndexSizeInBytes() {
+    if (builtIndex==false) {
+        cout << "! Index does not exist" <<endl;
+        return 0;
+    }
+    double size = compressedHops ? cInHops.sizeInBytes() + cOutHops.sizeInBytes() : inHops.sizeInBytes() + outHops.sizeInBytes();
+    if (dynamicHops)
+        size = sizeof(IndexNode)*VN + sizeof(pair<VertexID, LabelSet>)*getHopEntryCnt(index, VN);
+    if (labeled)
+        size += sizeof(unsigned char)*VN;
+    size += sizeof(VertexID)*VN + sizeof(UQFindexNode)*DAGVN;
+    return size;
+}
+
+
+template<typename IndexType>
+double HopIndex<IndexType>::getIndexEntryCnt() {
+    if (builtIndex==false) {
+        cout << "! Index does not exist" <<endl;
+        return 0;
+    }
+    if (compressedHops)
+        return cInHops.entryCnt() + cOutHops.entryCnt();
+    if (dynamicHops)
+        return getHopEntryCnt(index, VN);
+    return inHops.entryCnt() + outHops.entryCnt();
+}
+
+
+// answer queries by threadNum threads with work stealing, answers are written in input order and checked afterwards
+template<typename IndexType>
+double HopIndex<IndexType>::runQueriesInParallel(const vector<PerQuery>& queries) {
+    unsigned int num = getThreadNum();
+    printf("Start running %d queries with %u threads ...\n", int(queries.size()), num);
+
+    // each thread has its own query context
+    vector<QueryContext*> contexts(num);
+    for (unsigned int i=0; i<num; ++i)
+        contexts[i] = newQueryContext();
+    vector<char> answers(queries.size());
+
+    startRecordWallTime();
+    vector<WorkerStats> stats = runWithWorkStealing(queries.size(), num, [&](unsigned int tid, size_t i) {
+        const PerQuery& q = queries[i];
+        answers[i] = self().query(q.s, q.t, getQueryLabels(q, (IndexType*)NULL), contexts[tid]);
+    });
+    double queryTime = getElapsedWallTimeInMs();
+
+    for (size_t i=0; i<queries.size(); ++i) {
+        const PerQuery& q = queries[i];
+        if (bool(answers[i])==q.ans)
+            continue;
+        printf("! Error in %d-th query: %d->%d, label set: %s. Answer should be %s\n", int(i), q.s, q.t, labelSetToString(getQueryLabels(q, (IndexType*)NULL)).c_str(), q.ans?"true":"false");
+    }
+    printf("- Finished, wall time: %.2fms, throughput: %.0f queries/s\n", queryTime, queries.size()/max(queryTime, 1e-3)*1000);
+    printWorkerStats(stats);
+
+    for (QueryContext* c : contexts)
+        delete c;
+    return queryTime;
+}
+
+
+#endif
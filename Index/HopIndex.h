@@ -0,0 +1,157 @@
+/*
+LCR - Hop Index
+Author: Yuzheng Cai
+2022-10-27
+------------------------------
+C++ 11
+Parts of the 2-hop index shared by Index and IndexL, which only differ in how labels of edges and queries are
+mapped into label sets, so that IndexType (the derived class) provides the label-dependent parts
+*/
+
+#ifndef HOPINDEX_H
+#define HOPINDEX_H
+#include "../GraphUtils/Graph.cc"
+#include "GenerateDAG.cc"
+#include "UQF.cc"
+#include "QueryContext.h"
+#include "BuildContext.h"
+#include "HopIntersection.cc"
+#include "HopCompression.cc"
+#include "IndexFile.cc"
+
+
+class Index;
+class IndexL;
+
+
+// labels of a query as taken by query() of each index
+inline const LabelSet& getQueryLabels(const PerQuery& q, const Index*) { return q.ls; }
+inline const vector<LabelID>& getQueryLabels(const PerQuery& q, const IndexL*) { return q.lls; }
+inline bool isLargeLabelSet(const Index*) { return false; }
+inline bool isLargeLabelSet(const IndexL*) { return true; }
+
+
+// adjacency of the index, i.e., neighbors in the graph plus edges inserted after building, which are kept in added[v]
+// (NULL before the first insertion), so that DOR and pruned BFS follow inserted edges
+struct IndexNeighbors : public CSRneighbors {
+    vector<pair<VertexID, LabelID>>* added = NULL;
+    IndexNeighbors() {}
+    IndexNeighbors(const CSRneighbors& neighbors): CSRneighbors(neighbors) {}
+    inline EdgeID degree(const VertexID& v) const { return offsets[v+1]-offsets[v] + (added ? added[v].size() : 0); }
+
+    // neighbor and edge label of a vertex with degree one
+    inline VertexID uniqueNeighbor(const VertexID& v) const { return offsets[v+1]>offsets[v] ? ids[offsets[v]] : added[v][0].first; }
+    inline LabelID uniqueLabel(const VertexID& v) const { return offsets[v+1]>offsets[v] ? runLabels[runOffsets[v]] : added[v][0].second; }
+
+    // whether edge (v, u) with label l exists, including inserted edges
+    inline bool hasEdge(const VertexID& v, const VertexID& u, const LabelID& l) const {
+        if (CSRneighbors::hasEdge(v, u, l))
+            return true;
+        if (added)
+            for (const pair<VertexID, LabelID>& e : added[v])
+                if (e.first==u && e.second==l)
+                    return true;
+        return false;
+    }
+};
+
+
+template<typename IndexType>
+class HopIndex {
+    public:
+
+        // build and free index
+        double buildIndex();
+        void freeIndex();
+
+        // save built index to file, and load index from file via mmap, which returns -1 if the file is missing,
+        // corrupted or built on a different graph
+        void saveIndex(const string& filename);
+        double loadIndex(const string& filename);
+
+        // answering queries one by one or by several threads, where each thread has its own context
+        QueryContext* newQueryContext() const;
+        double runAllQueries(const vector<PerQuery>& queries);
+        double runQueriesInParallel(const vector<PerQuery>& queries);
+
+        // insert edge (s, t, label) and update the index incrementally, return false if the edge exists or is invalid,
+        // which must not run concurrently with queries
+        bool insertEdge(const VertexID& s, const VertexID& t, const LabelID& label);
+        double runEdgeInsertions(const vector<PerEdge>& edges, const double& rebuildTime, const vector<PerQuery>& queries);
+
+        // stats
+        double getIndexSizeInBytes();
+        double getIndexEntryCnt();
+
+    protected:
+        inline IndexType& self() { return *static_cast<IndexType*>(this); }
+        inline const IndexType& self() const { return *static_cast<const IndexType*>(this); }
+
+        // basic graph information
+        Graph* graph;
+        VertexID VN, DAGVN;
+        EdgeID EN;
+        LabelID labelNum;
+        IndexNeighbors inNeighbors, outNeighbors;
+
+        // built index
+        bool builtIndex = false;
+        unsigned long long hopRankingChecksum = 0;      // for checking that updates use the same hop order
+        LabelID budget = 0;                             // entries have at most budget labels, 0 for no limit
+        EdgeID insertedEdgeCnt = 0;
+
+        // build 2-hop index with degree-one reduction (DOR), where hop lists are packed into inHops and outHops afterwards,
+        // and IndexType explores the neighbors of frontiers by their labels
+        IndexNode* index;
+        BuildContext updateCtx;                         // for BFS resumed by edge insertions, adding entries directly
+        VertexID* hopRank = NULL;                       // hops with hopRank[v]<=order are processed
+        bool resuming = false;                          // BFS resumed by edge insertions, pruned by earlier hops only
+        vector<VertexID> allHops;
+        inline void visitForward(const VertexID& hopId, const VertexID& order, const VertexID& v, const LabelSet& ls, vector<pair<VertexID, LabelSet>>& toFrontier, BuildContext& c);
+        inline void visitBackward(const VertexID& hopId, const VertexID& order, const VertexID& v, const LabelSet& ls, vector<pair<VertexID, LabelSet>>& toFrontier, BuildContext& c);
+        void exploreForwardWithCurLabels(const VertexID& hopId, const VertexID& order, BuildContext& c);
+        void exploreForwardPlusOneLabel(const VertexID& hopId, const VertexID& order, BuildContext& c);
+        void exploreBackwardWithCurLabels(const VertexID& hopId, const VertexID& order, BuildContext& c);
+        void exploreBackwardPlusOneLabel(const VertexID& hopId, const VertexID& order, BuildContext& c);
+        inline bool queryForIndexForward(const VertexID& order, const VertexID& hopId, const VertexID& v, const LabelSet& ls, const BuildContext& c);
+        inline bool queryForIndexBackward(const VertexID& order, const VertexID& v, const VertexID& hopId, const LabelSet& ls, const BuildContext& c);
+        void loadRoot(const VertexID& hopId, bool backward, BuildContext& c);
+        void build2hop();
+        vector<VertexID> restrictToTerminals();
+        void dropUnlabeledHops();
+        void removeRedundantEntries();
+        VertexID chainEnd(const IndexNeighbors& neighbors, VertexID v) const;
+
+        // after inserting edges, hop lists are unpacked into index, and inserted edges are kept in inNeighbors and
+        // outNeighbors, UQF is bypassed if an inserted edge violates DAG orders (e.g., it merges SCCs)
+        bool dynamicHops = false, staleUQF = false;
+        void prepareForUpdates();
+        void collectInHops(const VertexID& v, vector<pair<VertexID, LabelSet>>& hops);
+        void collectOutHops(const VertexID& v, vector<pair<VertexID, LabelSet>>& hops);
+
+        // index restricted to terminals, where only v with labeled[v]&1 keeps out-hops, and only v with labeled[v]&2
+        // keeps in-hops, NULL for all vertices, and BFS of the hop with order i only visits v with fromOutEnd[v]>i (backward)
+        // or toInEnd[v]>i (forward) in building
+        unsigned char* labeled = NULL;
+        vector<VertexID> fromOutEnd, toInEnd;
+
+        // for online query
+        VertexID* raw2DAG;
+        UQFindexNode* UQForders;
+        PackedHops inHops, outHops;
+        bool compressedHops = false;
+        CompressedHops cInHops, cOutHops;
+        QueryContext* defaultContext = NULL;
+        void compressHops();
+        bool query2hop(const VertexID& s, const VertexID& t, const LabelSet& ls) const;
+        void verifyQueryFile(const vector<PerQuery>& queries);
+
+        // index loaded from file, whose arrays point into the mapped file, where the label mapping of IndexL is
+        // stored after the other arrays
+        void* mappedFile = NULL;
+        size_t mappedSize = 0;
+        IndexFileArrays getFileArrays(const IndexFileHeader& header, LabelID*& mapping);
+};
+
+
+#endif
@@ -0,0 +1,178 @@
+/*
+LCR - Intersection of Hop Lists
+Author: Yuzheng Cai
+2022-10-27
+------------------------------
+C++ 11 
+Vectorized kernels are compiled for their own instruction sets, and chosen at runtime
+*/ 
+
+#ifndef HOPINTERSECTION_CC
+#define HOPINTERSECTION_CC
+#include "HopIntersection.h"
+
+
+// whether some entry of hop id a->first in a and some entry of the same hop id in b have label sets in ls,
+// a and b are moved to the first entry of the next hop id
+inline bool checkSameHop(const HopEntry*& a, const HopEntry* aEnd, const HopEntry*& b, const HopEntry* bEnd, const LabelSet& ls) {
+    const VertexID hopId = a->first;
+    bool aPass = false, bPass = false;
+    for (; a!=aEnd && a->first==hopId; ++a)
+        aPass |= isSubset(a->second, ls);
+    for (; b!=bEnd && b->first==hopId; ++b)
+        bPass |= isSubset(b->second, ls);
+    return aPass && bPass;
+}
+
+
+bool intersectHopsScalar(const HopEntry* a, const HopEntry* aEnd, const HopEntry* b, const HopEntry* bEnd, const LabelSet& ls) {
+    while (a!=aEnd && b!=bEnd) {
+        if (a->first==b->first) {
+            if (checkSameHop(a, aEnd, b, bEnd, ls))
+                return true;
+        } else if (a->first<b->first)
+            a = lower_bound(a, aEnd, *b, cmpByFirstElement);
+        else
+            b = lower_bound(b, bEnd, *a, cmpByFirstElement);
+    }
+    return false;
+}
+
+
+bool intersectHopsGallop(const HopEntry* a, const HopEntry* aEnd, const HopEntry* b, const HopEntry* bEnd, const LabelSet& ls) {
+    while (a!=aEnd && b!=bEnd) {
+        if (isSubset(a->second, ls)==false) {
+            ++a;
+            continue;
+        }
+
+        // exponential search for the range containing a->first, then binary search in it
+        size_t step = 1;
+        const HopEntry* hi = b;
+        while (hi<bEnd && hi->first<a->first) {
+            b = hi+1;
+            hi = (size_t)(bEnd-b)>step ? b+step : bEnd;
+            step <<= 1;
+        }
+        b = lower_bound(b, hi<bEnd ? hi+1 : bEnd, *a, cmpByFirstElement);
+        if (b!=bEnd && b->first==a->first && checkSameHop(a, aEnd, b, bEnd, ls))
+            return true;
+        if (b==bEnd)
+            break;
+        // a is either on a passed hop id, or moved to the next hop id by checkSameHop
+        while (a!=aEnd && a->first<b->first)
+            ++a;
+    }
+    return false;
+}
+
+
+// move p to the first entry with hop id last in the block p[0...W-1], whose last entry has hop id last
+#define MOVE_TO_FIRST_OF_LAST(p, W, last) { int k = W-1; while (k>0 && p[k-1].first==last) --k; p += k; }
+
+
+// compare blocks of 4 entries of a and b all against all, where the block with smaller last hop id is dropped,
+// blocks with the same last hop id are resolved by checkSameHop, and remaining entries are merged by scalar kernel
+__attribute__((target("sse4.1")))
+bool intersectHopsSSE(const HopEntry* a, const HopEntry* aEnd, const HopEntry* b, const HopEntry* bEnd, const LabelSet& ls) {
+    const __m128i notLs = _mm_set1_epi32(~ls), zero = _mm_setzero_si128();
+    while (aEnd-a>=4 && bEnd-b>=4) {
+        const VertexID aLast = a[3].first, bLast = b[3].first;
+
+        // split entries into hop ids and label sets, an entry is usable if its label set is in ls
+        __m128 a0 = _mm_loadu_ps((const float*)a), a1 = _mm_loadu_ps((const float*)(a+2));
+        __m128 b0 = _mm_loadu_ps((const float*)b), b1 = _mm_loadu_ps((const float*)(b+2));
+        __m128i aIds = _mm_castps_si128(_mm_shuffle_ps(a0, a1, _MM_SHUFFLE(2,0,2,0)));
+        __m128i bIds = _mm_castps_si128(_mm_shuffle_ps(b0, b1, _MM_SHUFFLE(2,0,2,0)));
+        __m128i aUsable = _mm_cmpeq_epi32(_mm_and_si128(_mm_castps_si128(_mm_shuffle_ps(a0, a1, _MM_SHUFFLE(3,1,3,1))), notLs), zero);
+        __m128i bUsable = _mm_cmpeq_epi32(_mm_and_si128(_mm_castps_si128(_mm_shuffle_ps(b0, b1, _MM_SHUFFLE(3,1,3,1))), notLs), zero);
+
+        // all 4x4 pairs by rotating b
+        if (_mm_testz_si128(aUsable, aUsable)==0 && _mm_testz_si128(bUsable, bUsable)==0) {
+            __m128i hit = zero;
+            for (int r=0; r<4; ++r) {
+                hit = _mm_or_si128(hit, _mm_and_si128(_mm_cmpeq_epi32(aIds, bIds), _mm_and_si128(aUsable, bUsable)));
+                bIds = _mm_shuffle_epi32(bIds, _MM_SHUFFLE(0,3,2,1));
+                bUsable = _mm_shuffle_epi32(bUsable, _MM_SHUFFLE(0,3,2,1));
+            }
+            if (_mm_testz_si128(hit, hit)==0)
+                return true;
+        }
+
+        if (aLast<bLast)
+            a += 4;
+        else if (aLast>bLast)
+            b += 4;
+        else {
+            MOVE_TO_FIRST_OF_LAST(a, 4, aLast);
+            MOVE_TO_FIRST_OF_LAST(b, 4, bLast);
+            if (checkSameHop(a, aEnd, b, bEnd, ls))
+                return true;
+        }
+    }
+    return intersectHopsScalar(a, aEnd, b, bEnd, ls);
+}
+
+
+// same as intersectHopsSSE, with blocks of 8 entries
+__attribute__((target("avx2")))
+bool intersectHopsAVX2(const HopEntry* a, const HopEntry* aEnd, const HopEntry* b, const HopEntry* bEnd, const LabelSet& ls) {
+    const __m256i notLs = _mm256_set1_epi32(~ls), zero = _mm256_setzero_si256();
+    const __m256i rotate = _mm256_setr_epi32(1, 2, 3, 4, 5, 6, 7, 0);
+    while (aEnd-a>=8 && bEnd-b>=8) {
+        const VertexID aLast = a[7].first, bLast = b[7].first;
+
+        // split entries into hop ids and label sets, where lanes are out of order but consistent
+        __m256 a0 = _mm256_loadu_ps((const float*)a), a1 = _mm256_loadu_ps((const float*)(a+4));
+        __m256 b0 = _mm256_loadu_ps((const float*)b), b1 = _mm256_loadu_ps((const float*)(b+4));
+        __m256i aIds = _mm256_castps_si256(_mm256_shuffle_ps(a0, a1, _MM_SHUFFLE(2,0,2,0)));
+        __m256i bIds = _mm256_castps_si256(_mm256_shuffle_ps(b0, b1, _MM_SHUFFLE(2,0,2,0)));
+        __m256i aUsable = _mm256_cmpeq_epi32(_mm256_and_si256(_mm256_castps_si256(_mm256_shuffle_ps(a0, a1, _MM_SHUFFLE(3,1,3,1))), notLs), zero);
+        __m256i bUsable = _mm256_cmpeq_epi32(_mm256_and_si256(_mm256_castps_si256(_mm256_shuffle_ps(b0, b1, _MM_SHUFFLE(3,1,3,1))), notLs), zero);
+
+        // all 8x8 pairs by rotating b
+        if (_mm256_testz_si256(aUsable, aUsable)==0 && _mm256_testz_si256(bUsable, bUsable)==0) {
+            __m256i hit = zero;
+            for (int r=0; r<8; ++r) {
+                hit = _mm256_or_si256(hit, _mm256_and_si256(_mm256_cmpeq_epi32(aIds, bIds), _mm256_and_si256(aUsable, bUsable)));
+                bIds = _mm256_permutevar8x32_epi32(bIds, rotate);
+                bUsable = _mm256_permutevar8x32_epi32(bUsable, rotate);
+            }
+            if (_mm256_testz_si256(hit, hit)==0)
+                return true;
+        }
+
+        if (aLast<bLast)
+            a += 8;
+        else if (aLast>bLast)
+            b += 8;
+        else {
+            MOVE_TO_FIRST_OF_LAST(a, 8, aLast);
+            MOVE_TO_FIRST_OF_LAST(b, 8, bLast);
+            if (checkSameHop(a, aEnd, b, bEnd, ls))
+                return true;
+        }
+    }
+    return intersectHopsScalar(a, aEnd, b, bEnd, ls);
+}
+
+
+// choose the fastest kernel supported by the CPU
+HopIntersectFunc chooseIntersectHopsKernel(const char*& name) {
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        name = "avx2";
+        return intersectHopsAVX2;
+    }
+    if (__builtin_cpu_supports("sse4.1")) {
+        name = "sse4.1";
+        return intersectHopsSSE;
+    }
+    name = "scalar";
+    return intersectHopsScalar;
+}
+const char* intersectHopsKernelName = "scalar";
+HopIntersectFunc intersectHopsKernel = chooseIntersectHopsKernel(intersectHopsKernelName);
+
+
+#endif
@@ -0,0 +1,48 @@
+/*
+LCR - Intersection of Hop Lists
+Author: Yuzheng Cai
+2022-10-27
+------------------------------
+C++ 11 
+Check whether outHops[s] and inHops[t] share a hop, whose entries in both lists have label sets contained in ls
+*/ 
+
+#ifndef HOPINTERSECTION_H
+#define HOPINTERSECTION_H
+#include "../GraphUtils/Utils.h"
+#include <immintrin.h>
+
+
+// hop lists are sorted by hop id, and one hop may have several entries with different label sets
+typedef pair<VertexID, LabelSet> HopEntry;
+static_assert(sizeof(HopEntry)==8, "vectorized kernels assume 32-bit hop ids and label sets");
+typedef bool (*HopIntersectFunc)(const HopEntry*, const HopEntry*, const HopEntry*, const HopEntry*, const LabelSet&);
+
+// merge-based kernels
+bool intersectHopsScalar(const HopEntry* a, const HopEntry* aEnd, const HopEntry* b, const HopEntry* bEnd, const LabelSet& ls);
+bool intersectHopsSSE(const HopEntry* a, const HopEntry* aEnd, const HopEntry* b, const HopEntry* bEnd, const LabelSet& ls);
+bool intersectHopsAVX2(const HopEntry* a, const HopEntry* aEnd, const HopEntry* b, const HopEntry* bEnd, const LabelSet& ls);
+
+// binary search each entry of the short list a in the long list b, for lists with very different sizes
+bool intersectHopsGallop(const HopEntry* a, const HopEntry* aEnd, const HopEntry* b, const HopEntry* bEnd, const LabelSet& ls);
+
+// galloping is used when one list is GALLOP_RATIO times longer than the other, otherwise the fastest kernel
+// supported by the CPU is used
+#define GALLOP_RATIO 16
+extern HopIntersectFunc intersectHopsKernel;
+extern const char* intersectHopsKernelName;
+inline bool intersectHops(const HopEntry* a, const HopEntry* aEnd, const HopEntry* b, const HopEntry* bEnd, const LabelSet& ls) {
+    if (a==aEnd || b==bEnd)
+        return false;
+    if ((size_t)(aEnd-a)*GALLOP_RATIO < (size_t)(bEnd-b))
+        return intersectHopsGallop(a, aEnd, b, bEnd, ls);
+    if ((size_t)(bEnd-b)*GALLOP_RATIO < (size_t)(aEnd-a))
+        return intersectHopsGallop(b, bEnd, a, aEnd, ls);
+    return intersectHopsKernel(a, aEnd, b, bEnd, ls);
+}
+inline bool intersectHops(const vector<HopEntry>& a, const vector<HopEntry>& b, const LabelSet& ls) {
+    return intersectHops(a.data(), a.data()+a.size(), b.data(), b.data()+b.size(), ls);
+}
+
+
+#endif
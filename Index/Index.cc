@@ -18,389 +18,302 @@ Index::Index(Graph* inputGraph) {
     VN = graph->VN;
     EN = graph->EN;
     labelNum = graph->labelNum;
-    neighbors = graph->neighbors;
+    inNeighbors = graph->in;
+    outNeighbors = graph->out;
+    collapsed = graph->collapsed;
+    maskedIn = graph->maskedIn;
+    maskedOut = graph->maskedOut;
 }
 
 
-double Index::buildIndex() {
-    if (builtIndex) {
-        cout << "! Index already exists" <<endl;
-        return 0;
-    }
-    index = new IndexNode[VN];
-
-    // memory reused by several subtasks
-    int* intVNreuse = new int[VN]();
-    VertexID* vidVNreuse1 = new VertexID[VN+1];
-    VertexID* vidVNreuse2 = new VertexID[VN];
-    bool* boolVNreuse = new bool[VN]();
-    
-    // build DAG for unreachable query filter (UQF)
-    cout<<"Start building DAG ..."<<endl;
-    startRecordTime();
-    GenerateDAG dag(graph, intVNreuse, vidVNreuse1, vidVNreuse2, boolVNreuse);
-    double genDAGtime = getElapsedTimeInMs();
-    cout<<"- Finished. DAG has "<<dag.DAGVM<<" vertices and "<<dag.DAGEN<<" edges, degree="<<(dag.DAGEN)/float(dag.DAGVM)<<". Time cost: "<<genDAGtime<<" ms"<<endl;
-
-    // obtain vertex id mapping from original graph to DAG
-    DAGVN = dag.DAGVM;
-    for (VertexID i=0; i<VN; ++i)
-        index[i].raw2DAG = dag.raw2DAG[i];
-    dag.freeMemory();
-    
-    // generate unreachable query filter index (UQF)
-    cout<<"Start building unreachable query filter index ..."<<endl;
-    startRecordTime();
-    UQF UQFindex(&dag, vidVNreuse1, vidVNreuse2, boolVNreuse);
-    double UQFindexTime = getElapsedTimeInMs();
-    cout<<"- Finished. Time cost: "<<UQFindexTime<<" ms"<<endl;
-
-    // obtain unreachable query filter (UQF) index
-    UQForders = UQFindex.UQForders;
-    UQFindex.freeMemory();
-    delete[] dag.DAGneighbors;
-
-    // free unuseful memory reused by several subtasks
-    visited = intVNreuse;
-    isProcessed = boolVNreuse;
-    delete[] vidVNreuse1;
-    delete[] vidVNreuse2;
-
-    // build 2-hop index using degree-one reduction (DOR)
-    printf("Start building P2H+ index with degree-one reduction ...\n");
-    startRecordTime();
-    build2hop();
-    double P2HindexTime = getElapsedTimeInMs();
-    printf("- Finished, time cost: %.2fms\n", P2HindexTime);
-
-    // return total time cost
-    builtIndex = true;
-    return genDAGtime + UQFindexTime + P2HindexTime;
+// labels are not mapped, so that index file has no label mapping
+void Index::saveLabelMapping(IndexFileHeader&, LabelID*&) {}
+void Index::loadLabelMapping(const IndexFileHeader&, const LabelID*) {}
+
+
+// neighbors of u in runs sharing labels, i.e., f(begin, end, labels) for each run of neighbor ids, where edges
+// collapsed into masks are runs of one neighbor
+template<typename F>
+inline void Index::forEachInRun(const VertexID& u, F f) const {
+    if (collapsed) {
+        for (EdgeID e=maskedIn.offsets[u]; e<maskedIn.offsets[u+1]; ++e)
+            f(maskedIn.ids+e, maskedIn.ids+e+1, maskedIn.masks[e]);
+    } else
+        for (EdgeID r=inNeighbors.runOffsets[u]; r<inNeighbors.runOffsets[u+1]; ++r)
+            f(inNeighbors.ids+inNeighbors.runStarts[r], inNeighbors.ids+inNeighbors.runStarts[r+1], labelBit(inNeighbors.runLabels[r]));
+    if (inNeighbors.added)
+        for (const pair<VertexID, LabelID>& e : inNeighbors.added[u])
+            f(&e.first, &e.first+1, labelBit(e.second));
 }
 
 
-void Index::freeIndex() {
-    if (builtIndex) {
-        delete[] index;
-        delete[] UQForders;
-        delete[] visited;
-        builtIndex = false;
-    }
+template<typename F>
+inline void Index::forEachOutRun(const VertexID& u, F f) const {
+    if (collapsed) {
+        for (EdgeID e=maskedOut.offsets[u]; e<maskedOut.offsets[u+1]; ++e)
+            f(maskedOut.ids+e, maskedOut.ids+e+1, maskedOut.masks[e]);
+    } else
+        for (EdgeID r=outNeighbors.runOffsets[u]; r<outNeighbors.runOffsets[u+1]; ++r)
+            f(outNeighbors.ids+outNeighbors.runStarts[r], outNeighbors.ids+outNeighbors.runStarts[r+1], labelBit(outNeighbors.runLabels[r]));
+    if (outNeighbors.added)
+        for (const pair<VertexID, LabelID>& e : outNeighbors.added[u])
+            f(&e.first, &e.first+1, labelBit(e.second));
 }
 
 
-double Index::runAllQueries(const vector<PerQuery>& queries) {
-    if (builtIndex==false) {
-        cout << "! Index does not exist" <<endl;
-        return 0;
-    }
-
-    printf("Start running %d queries ...\n", int(queries.size()));
-    startRecordTime();
-    for (int i=0; i<queries.size(); ++i) {
-        const PerQuery& q = queries[i];
-        VertexID s=q.s, t=q.t;
-        const LabelSet& ls=q.ls;
-        
-        if (query(s, t, ls)==q.ans)
-            continue;
-        printf("! Error in %d-th query: %d->%d, label set: %s. Answer should be %s\n", i, s, t, labelSetToString(ls).c_str(), q.ans?"true":"false");
+// unreachable query filter (UQF), return false if t is unreachable from s for sure
+inline bool Index::passUQF(const VertexID& s, const VertexID& t) const {
+    const VertexID& sDAG = raw2DAG[s];
+    const VertexID& tDAG = raw2DAG[t];
+    if (sDAG!=tDAG && staleUQF==false) {
+        const UQFindexNode& nS = UQForders[sDAG];
+        const UQFindexNode& nT = UQForders[tDAG];
+        if ( nS.X>=nT.X || nS.Y>=nT.Y || nS.level>=nT.level || nS.H1>=nT.H1 || nS.H2>=nT.H2 )
+            return false;
     }
-
-    double queryTime = getElapsedTimeInMs();
-    printf("- Finished, time cost: %.2fms\n", queryTime);
-    return queryTime;
+    return true;
 }
 
 
-void Index::build2hop() {
-
-    // init local variables
-    memset(isProcessed, 0, sizeof(bool)*VN);
-    pair<VertexID, VertexID>* allHops = new pair<VertexID, VertexID>[VN];
-
-    // sort by degree
-    for (VertexID id=0; id<VN; ++id)
-        allHops[id] = {id, neighbors[id].inDegree+neighbors[id].outDegree};
-    sort(allHops, allHops+VN, 
-         [](const pair<VertexID, VertexID>& a, const pair<VertexID, VertexID>& b) {
-                return a.second>b.second;
-            });
-
-    // process each hop
-    for (VertexID order=0; order<VN; ++order) {
-        const VertexID& hopId = allHops[order].first;
-        isProcessed[hopId] = true;
-
-        // backward BFS
-        frontier.emplace_back(hopId, 0);
-        while (!frontier.empty()) {
-            exploreBackwardWithCurLabels(hopId, order);
-            exploreBackwardPlusOneLabel(hopId, order);
-        }
-
-        // forward BFS
-        frontier.emplace_back(hopId, 0);
-        while (!frontier.empty()) {
-            exploreForwardWithCurLabels(hopId, order);
-            exploreForwardPlusOneLabel(hopId, order);
-        }
-
-        if (neighbors[hopId].inDegree>1)
-            index[hopId].inHops.emplace_back(order, 0);
-        if (neighbors[hopId].outDegree>1)
-            index[hopId].outHops.emplace_back(order, 0);
+// transform to unique neighbors, i.e., using degree-one reduction (DOR)
+// return 0 or 1 if the query is answered, otherwise return -1 with curS and curT updated
+inline int Index::reduceDegreeOne(VertexID& curS, VertexID& curT, const LabelSet& ls, QueryContext& c) const {
+    int* visited = c.visited;
+    int offset = c.nextMark();
+    visited[curS] = offset;
+    while (outNeighbors.degree(curS)==1) {
+        if ( (1<<(outNeighbors.uniqueLabel(curS)) & ls)==0 ) return 0;
+        curS = outNeighbors.uniqueNeighbor(curS);
+        if (curS==curT) return 1;
+        if (visited[curS]==offset) return 0;
+        visited[curS] = offset;
     }
-    
-    // free memory
-    delete[] isProcessed;
-    delete[] allHops;
-    vector<pair<VertexID, LabelSet>> tmp1, tmp2;
-    frontier.swap(tmp1);
-    nxtFrontier.swap(tmp2);
-}
-
-
-void Index::exploreBackwardWithCurLabels(const VertexID& hopId, const VertexID& order) {
-    VertexID curIdx = 0;
-    while (curIdx<frontier.size()) {
-        const VertexID u = frontier[curIdx].first;
-        const LabelSet ls = frontier[curIdx].second;
-        ++curIdx;
-        for (LabelID label=0; label<labelNum; ++label)
-            if ( (ls>>label)&1 )
-                if ( neighbors[u].in.find(label)!=neighbors[u].in.end() )
-                    for (const VertexID& v : neighbors[u].in[label]) {
-                        if (isProcessed[v] || queryForIndexBackward(order, v, hopId, ls)) 
-                            continue;
-                        if (neighbors[v].outDegree!=1)
-                            index[v].outHops.emplace_back(order, ls);
-                        frontier.emplace_back(v, ls);
-                    }
+    offset = c.nextMark();
+    visited[curT] = offset;
+    while (inNeighbors.degree(curT)==1) {
+        if ( (1<<(inNeighbors.uniqueLabel(curT)) & ls)==0 ) return 0;
+        curT = inNeighbors.uniqueNeighbor(curT);
+        if (curS==curT) return 1;
+        if (visited[curT]==offset) return 0;
+        visited[curT] = offset;
     }
+    return -1;
 }
 
 
-void Index::exploreBackwardPlusOneLabel(const VertexID& hopId, const VertexID& order) {
-    VertexID curIdx = 0;
-    nxtFrontier.clear();
-    while (curIdx<frontier.size()) {
-        const VertexID& u = frontier[curIdx].first;
-        const LabelSet& ls = frontier[curIdx].second;
-        ++curIdx;
-        for (auto iter=neighbors[u].in.begin(); iter!=neighbors[u].in.end(); ++iter) {
-            const LabelSet newLabel = 1<<(iter->first);
-            if ( ( ls & newLabel ) == 0 )
-                for (const auto& v : iter->second) { 
-                    LabelSet newLabelSet = ls | newLabel;
-                    if (isProcessed[v] || queryForIndexBackward(order, v, hopId, newLabelSet))
-                        continue;
-                    if (neighbors[v].outDegree!=1)
-                        index[v].outHops.emplace_back(order, newLabelSet);
-                    nxtFrontier.emplace_back(v, newLabelSet);
-                } 
-        }
+bool Index::query(const VertexID& rawS, const VertexID& rawT, const LabelSet& ls, QueryContext* ctx) const {
+    if (builtIndex==false) {
+        cout << "! Index does not exist" <<endl;
+        return false;
     }
-    frontier.swap(nxtFrontier);
-}
+    if (rawS==rawT) return true;
+    QueryContext& c = ctx ? *ctx : *defaultContext;
+    const VertexID s = graph->toNewId(rawS), t = graph->toNewId(rawT);
 
+    // unreachable query filter (UQF)
+    if (passUQF(s, t)==false)
+        return false;
 
-void Index::exploreForwardWithCurLabels(const VertexID& hopId, const VertexID& order) {
-    VertexID curIdx = 0;
-    while (curIdx<frontier.size()) {
-        const VertexID u = frontier[curIdx].first;
-        const LabelSet ls = frontier[curIdx].second;
-        ++curIdx;
-        for (LabelID label=0; label<labelNum; ++label)
-            if ( (ls>>label)&1 )
-                if ( neighbors[u].out.find(label)!=neighbors[u].out.end() )
-                    for (const VertexID& v : neighbors[u].out[label]) {
-                        if (isProcessed[v] || queryForIndexForward(order, hopId, v, ls)) 
-                            continue; 
-                        if (neighbors[v].inDegree!=1) 
-                            index[v].inHops.emplace_back(order, ls);
-                        frontier.emplace_back(v, ls);
-                    }
-    }
+    // degree-one reduction (DOR)
+    VertexID curS = s, curT = t;
+    int ans = reduceDegreeOne(curS, curT, ls, c);
+    if (ans>=0)
+        return ans;
+
+    // query 2-hop index, whose entries have at most budget labels and may be kept by only ends of DOR chains of terminals, so that
+    // other queries fall back to search if the index does not find a path
+    if (query2hop(curS, curT, ls))
+        return true;
+    return answeredByIndex(curS, curT, ls)==false && searchFallback(curS, curT, ls, c);
 }
 
 
-void Index::exploreForwardPlusOneLabel(const VertexID& hopId, const VertexID& order) {
-    VertexID curIdx = 0;
-    nxtFrontier.clear();
-    while (curIdx<frontier.size()) {
-        const VertexID& u = frontier[curIdx].first;
-        const LabelSet& ls = frontier[curIdx].second;
-        ++curIdx;
-        for (auto iter=neighbors[u].out.begin(); iter!=neighbors[u].out.end(); ++iter) {
-            const LabelSet newLabel = 1<<(iter->first);
-            if ( ( ls & newLabel ) == 0 )
-                for (const auto& v : iter->second) { 
-                    LabelSet newLabelSet = ls | newLabel;
-                    if (isProcessed[v] || queryForIndexForward(order, hopId, v, newLabelSet)) 
-                        continue;
-                    if (neighbors[v].inDegree!=1) 
-                        index[v].inHops.emplace_back(order, newLabelSet);
-                    nxtFrontier.emplace_back(v, newLabelSet);
-                } 
-        }
-    }
-    frontier.swap(nxtFrontier);
+// whether the index answers query (s, t, ls) exactly, i.e., without falling back to search
+inline bool Index::answeredByIndex(const VertexID& s, const VertexID& t, const LabelSet& ls) const {
+    return (budget==0 || __builtin_popcount(ls)<=budget) && (labeled==NULL || ((labeled[s]&1) && (labeled[t]&2)));
 }
 
 
-inline bool Index::queryForIndexForward(const VertexID& order, const VertexID& hopId, const VertexID& v, const LabelSet& ls) {
-
-    if (neighbors[v].inDegree!=1) {
-        auto iter = index[v].inHops.rbegin();
-        while (iter!=index[v].inHops.rend() && iter->first==order) {
-            if (isSubset(iter->second, ls))
-                return true;
-            ++iter;
-        }
-    }
+// BFS from s via edges with labels in ls, where a visited vertex reaching t by the index is not expanded further,
+// i.e., t is reached, since entries of the index are paths of the graph, and neither is a vertex that the index
+// answers exactly
+bool Index::searchFallback(const VertexID& s, const VertexID& t, const LabelSet& ls, QueryContext& c) const {
+    int* visitedS = c.visitedS;
+    const int offsetS = c.nextMarkS();
+    VertexID* Q = c.Q;
+    VertexID queueBegin = 0, queueEnd = 1;
+    visitedS[s] = offsetS;
+    Q[queueBegin] = s;
 
-    VertexID cur = hopId;
-    while (neighbors[cur].outDegree==1) {
-        cur = neighbors[cur].out.begin()->second[0];
-        if (cur==v) return false;
+    auto visit = [&](const VertexID& nxt) -> bool {
+        if (visitedS[nxt]==offsetS)
+            return false;
+        visitedS[nxt] = offsetS;
+        if (nxt==t || query2hop(nxt, t, ls))
+            return true;
+        if (passUQF(nxt, t) && answeredByIndex(nxt, t, ls)==false)
+            Q[queueEnd++] = nxt;
+        return false;
+    };
+
+    while (queueBegin<queueEnd) {
+        const VertexID cur = Q[queueBegin++];
+        for (EdgeID r=outNeighbors.runOffsets[cur]; r<outNeighbors.runOffsets[cur+1]; ++r)
+            if ((ls>>outNeighbors.runLabels[r])&1)
+                for (EdgeID e=outNeighbors.runStarts[r]; e<outNeighbors.runStarts[r+1]; ++e)
+                    if (visit(outNeighbors.ids[e]))
+                        return true;
+        if (outNeighbors.added)
+            for (const pair<VertexID, LabelID>& e : outNeighbors.added[cur])
+                if (((ls>>e.second)&1) && visit(e.first))
+                    return true;
     }
-
-    // query 2-hop index
-    return query2hop(cur, v, ls);
+    return false;
 }
 
 
-inline bool Index::queryForIndexBackward(const VertexID& order, const VertexID& v, const VertexID& hopId, const LabelSet& ls) {
+// advance an in-flight query by one stage, and prefetch data used by its next stage
+// return true if the query is answered
+inline bool Index::advanceQuery(InflightQuery& q, const PerQuery& pq, char& ans, QueryContext& c) const {
+    switch (q.stage) {
 
-    if (neighbors[v].outDegree!=1) {
-        auto iter = index[v].outHops.rbegin();
-        while (iter!=index[v].outHops.rend() && iter->first==order) {
-            if (isSubset(iter->second, ls))
+        // translate endpoints, prefetch their index nodes
+        case 0:
+            if (pq.s==pq.t) {
+                ans = 1;
                 return true;
-            ++iter;
+            }
+            q.curS = graph->toNewId(pq.s);
+            q.curT = graph->toNewId(pq.t);
+            __builtin_prefetch(&raw2DAG[q.curS]);
+            __builtin_prefetch(&raw2DAG[q.curT]);
+            break;
+
+        // prefetch UQF nodes and neighbor offsets
+        case 1:
+            __builtin_prefetch(&UQForders[raw2DAG[q.curS]]);
+            __builtin_prefetch(&UQForders[raw2DAG[q.curT]]);
+            __builtin_prefetch(&outNeighbors.offsets[q.curS]);
+            __builtin_prefetch(&inNeighbors.offsets[q.curT]);
+            if (dynamicHops) {
+                __builtin_prefetch(&index[q.curS].outHops);
+                __builtin_prefetch(&index[q.curT].inHops);
+            } else {
+                __builtin_prefetch(compressedHops ? &cOutHops.offsets[q.curS] : &outHops.offsets[q.curS]);
+                __builtin_prefetch(compressedHops ? &cInHops.offsets[q.curT] : &inHops.offsets[q.curT]);
+            }
+            break;
+
+        // UQF and DOR, prefetch hop lists
+        case 2: {
+            if (passUQF(q.curS, q.curT)==false) {
+                ans = 0;
+                return true;
+            }
+            int res = reduceDegreeOne(q.curS, q.curT, pq.ls, c);
+            if (res>=0) {
+                ans = res;
+                return true;
+            }
+            if (compressedHops) {
+                __builtin_prefetch(cOutHops.begin(q.curS));
+                __builtin_prefetch(cInHops.begin(q.curT));
+            } else if (dynamicHops) {
+                __builtin_prefetch(index[q.curS].outHops.data());
+                __builtin_prefetch(index[q.curT].inHops.data());
+            } else {
+                __builtin_prefetch(outHops.begin(q.curS));
+                __builtin_prefetch(inHops.begin(q.curT));
+            }
+            break;
         }
-    } 
-
-    VertexID cur = hopId;
-    while (neighbors[cur].inDegree==1) {
-        cur = neighbors[cur].in.begin()->second[0];
-        if (cur==v) return false;
-    }
-
-    // query 2-hop index
-    return query2hop(v, cur, ls);
-}
-
 
-bool Index::query2hop(const VertexID& s, const VertexID& t, const LabelSet& ls) {
-    auto i=index[s].outHops.begin(), j=index[t].inHops.begin();
-    while (i!=index[s].outHops.end() && j!=index[t].inHops.end()) {
-
-        // same hop id
-        if (i->first==j->first) {
-            const VertexID& hopId = i->first;
-
-            // check for i
-            bool iPass = false;
-            do {
-                if (isSubset(i->second, ls)) {
-                    iPass = true;
-                    break;
-                }
-                ++i;
-            } while (i!=index[s].outHops.end() && i->first==hopId);
-
-            // check for j
-            if (iPass) {
-                do {
-                    if (isSubset(j->second, ls)) 
-                        return true;
-                    ++j;
-                } while (j!=index[t].inHops.end() && j->first==hopId);
-
-                // move i to next hop id
-                while (i!=index[s].outHops.end() && i->first==hopId)
-                    ++i;
-
-            // move j to next hop id
-            } else 
-                while (j!=index[t].inHops.end() && j->first==hopId)
-                    ++j;
-
-        // hop id not the same
-        } else if (i->first<j->first)
-            i = lower_bound(i, index[s].outHops.end(), *j, cmpByFirstElement);
-        else
-            j = lower_bound(j, index[t].inHops.end(), *i, cmpByFirstElement);
+        // query 2-hop index, queries not answered by the index may fall back to search
+        default:
+            ans = query2hop(q.curS, q.curT, pq.ls) || (answeredByIndex(q.curS, q.curT, pq.ls)==false && searchFallback(q.curS, q.curT, pq.ls, c));
+            return true;
     }
+    ++q.stage;
     return false;
 }
 
 
-bool Index::query(const VertexID& s, const VertexID& t, const LabelSet& ls) {
-    if (builtIndex==false) {
-        cout << "! Index does not exist" <<endl;
-        return false;
-    }
-    if (s==t) return true;
-
-    // unreachable query filter (UQF)
-    const VertexID& sDAG = index[s].raw2DAG;
-    const VertexID& tDAG = index[t].raw2DAG;
-    if (sDAG!=tDAG) {
-        const UQFindexNode& nS = UQForders[sDAG];
-        const UQFindexNode& nT = UQForders[tDAG];
-        if ( nS.X>=nT.X || nS.Y>=nT.Y || nS.level>=nT.level || nS.H1>=nT.H1 || nS.H2>=nT.H2 )
-            return false;
-    }
-
-    // transform to unique neighbors, i.e., using degree-one reduction (DOR)
-    VertexID curS = s, curT = t;
-    visited[curS] = ++offset;
-    while (neighbors[curS].outDegree==1) {
-        if ( (1<<(neighbors[curS].out.begin()->first) & ls)==0 ) return false;
-        curS = neighbors[curS].out.begin()->second[0];
-        if (curS==curT) return true;
-        if (visited[curS]==offset) return false;
-        visited[curS] = offset;
-    }
-    visited[curT] = ++offset;
-    while (neighbors[curT].inDegree==1) {
-        if ( (1<<(neighbors[curT].in.begin()->first) & ls)==0 ) return false;
-        curT = neighbors[curT].in.begin()->second[0];
-        if (curS==curT) return true;
-        if (visited[curT]==offset) return false;
-        visited[curT] = offset;
+// answer queries with groupSize queries in flight, advancing them in a round-robin way, so that
+// memory accesses of different queries overlap
+void Index::queryInterleaved(const vector<PerQuery>& queries, vector<char>& answers, const unsigned int& groupSize, QueryContext* ctx) const {
+    QueryContext& c = ctx ? *ctx : *defaultContext;
+    const size_t n = queries.size();
+    answers.assign(n, 0);
+
+    vector<InflightQuery> group(groupSize);
+    size_t nxt = 0;
+    unsigned int active = 0;
+    for (InflightQuery& q : group) {
+        q.id = n;
+        if (nxt<n) {
+            q.id = nxt++;
+            q.stage = 0;
+            ++active;
+        }
     }
 
-    // query 2-hop index
-    return query2hop(curS, curT, ls);
+    while (active>0)
+        for (InflightQuery& q : group) {
+            if (q.id==n || advanceQuery(q, queries[q.id], answers[q.id], c)==false)
+                continue;
+            if (nxt<n) {
+                q.id = nxt++;
+                q.stage = 0;
+            } else {
+                q.id = n;
+                --active;
+            }
+        }
 }
 
 
-double Index::getIndexSizeInBytes() {
-    if (builtIndex==false) {
-        cout << "! Index does not exist" <<endl;
-        return 0;
-    }
-    double size = 0;
-    for (VertexID i=0; i<VN; ++i) 
-        size += sizeof(pair<VertexID, LabelSet>)*(index[i].inHops.size()+index[i].outHops.size()); //+ sizeof(inHops[i]) + sizeof(outHops[i]);
-    size += sizeof(VertexID)*VN + sizeof(UQFindexNode)*DAGVN;
-    return size;
+// queries are answered by the interleaved pipeline if interleavedQueries is set, otherwise as in HopIndex
+double Index::runAllQueries(const vector<PerQuery>& queries) {
+    if (interleavedQueries==false || parallelQueries || builtIndex==false)
+        return HopIndex<Index>::runAllQueries(queries);
+    double queryTime = runQueriesInterleaved(queries);
+    if (verifyQueries)
+        verifyQueryFile(queries);
+    return queryTime;
 }
 
 
-double Index::getIndexEntryCnt() {
-    if (builtIndex==false) {
-        cout << "! Index does not exist" <<endl;
-        return 0;
+// compare the scalar query loop with interleaved pipeline of different group sizes
+double Index::runQueriesInterleaved(const vector<PerQuery>& queries) {
+    printf("Start running %d queries by interleaved pipeline ...\n", int(queries.size()));
+    vector<char> answers(queries.size());
+
+    // the first pass warms up caches, so that all variants are measured under the same condition
+    double scalarTime = 0;
+    for (int pass=0; pass<2; ++pass) {
+        startRecordWallTime();
+        for (size_t i=0; i<queries.size(); ++i)
+            answers[i] = query(queries[i].s, queries[i].t, queries[i].ls);
+        scalarTime = getElapsedWallTimeInMs();
+    }
+    printf("- Scalar loop, wall time: %.2fms\n", scalarTime);
+
+    double bestTime = scalarTime;
+    for (unsigned int groupSize=1; groupSize<=64; groupSize*=2) {
+        startRecordWallTime();
+        queryInterleaved(queries, answers, groupSize);
+        double queryTime = getElapsedWallTimeInMs();
+        bestTime = min(bestTime, queryTime);
+
+        int errorCnt = 0;
+        for (size_t i=0; i<queries.size(); ++i)
+            if (bool(answers[i])!=queries[i].ans) {
+                ++errorCnt;
+                printf("! Error in %d-th query: %d->%d, label set: %s. Answer should be %s\n", int(i), queries[i].s, queries[i].t, labelSetToString(queries[i].ls).c_str(), queries[i].ans?"true":"false");
+            }
+        printf("- Group size %u, wall time: %.2fms, speedup: %.2fx, errors: %d\n", groupSize, queryTime, scalarTime/max(queryTime, 1e-3), errorCnt);
     }
-    double cnt = 0;
-    for (VertexID i=0; i<VN; ++i) 
-        cnt += index[i].inHops.size()+index[i].outHops.size();
-    return cnt;
+    return bestTime;
 }
 
 
@@ -10,53 +10,49 @@ Implementations for graphs with small number of labels
 
 #ifndef INDEX_H
 #define INDEX_H
-#include "../GraphUtils/Graph.cc"
-#include "GenerateDAG.cc"
-#include "UQF.cc"
+#include "HopIndex.cc"
 
 
-class Index {
+// state of an in-flight query in the interleaved query pipeline
+struct InflightQuery {
+    size_t id;                                      // position in the query vector
+    VertexID curS, curT;
+    int stage;
+};
+
+
+class Index : public HopIndex<Index> {
+    friend class HopIndex<Index>;
+
     public:
         Index(Graph* graph);
 
-        // build and free index
-        double buildIndex();
-        void freeIndex();
-
-        // answering queries
-        bool query(const VertexID& s, const VertexID& t, const LabelSet& ls);
+        // answering queries, the built index is never modified, so that threads with their own contexts can query concurrently
+        bool query(const VertexID& s, const VertexID& t, const LabelSet& ls, QueryContext* ctx=NULL) const;
         double runAllQueries(const vector<PerQuery>& queries);
-        
-        // stats
-        double getIndexSizeInBytes();
-        double getIndexEntryCnt();
+        void queryInterleaved(const vector<PerQuery>& queries, vector<char>& answers, const unsigned int& groupSize, QueryContext* ctx=NULL) const;
+        double runQueriesInterleaved(const vector<PerQuery>& queries);
 
     private:
 
-        // basic graph information
-        Graph* graph;
-        VertexID VN, DAGVN;
-        EdgeID EN;
-        LabelID labelNum;
-        PerNeighbor* neighbors;
+        // parallel edges collapsed into label masks
+        bool collapsed;
+        MaskedNeighbors maskedIn, maskedOut;
+        inline LabelSet labelBit(const LabelID& label) const { return 1<<label; }              // labels are used directly
+        inline void divideLabels() {}                                                          // no secondary labels, no-op
+        void saveLabelMapping(IndexFileHeader& header, LabelID*& mapping);     // labels are not mapped, no-op
+        void loadLabelMapping(const IndexFileHeader& header, const LabelID* mapping);
         
-        // build 2-hop index with degree-one reduction (DOR)
-        bool builtIndex = false;
-        vector<pair<VertexID, LabelSet>> frontier, nxtFrontier;
-        bool* isProcessed;
-        int *visited, offset=1;
-        void exploreForwardWithCurLabels(const VertexID& hopId, const VertexID& order);
-        void exploreForwardPlusOneLabel(const VertexID& hopId, const VertexID& order);
-        void exploreBackwardWithCurLabels(const VertexID& hopId, const VertexID& order);
-        void exploreBackwardPlusOneLabel(const VertexID& hopId, const VertexID& order);
-        inline bool queryForIndexForward(const VertexID& order, const VertexID& hopId, const VertexID& v, const LabelSet& ls);
-        inline bool queryForIndexBackward(const VertexID& order, const VertexID& v, const VertexID& hopId, const LabelSet& ls);
-        void build2hop();
+        // neighbors of u in runs of ids sharing labels, i.e., f(begin, end, labels) for each run, for pruned BFS
+        template<typename F> inline void forEachInRun(const VertexID& u, F f) const;
+        template<typename F> inline void forEachOutRun(const VertexID& u, F f) const;
 
         // for online query
-        IndexNode* index;
-        UQFindexNode* UQForders;
-        bool query2hop(const VertexID& s, const VertexID& t, const LabelSet& ls);
+        inline bool answeredByIndex(const VertexID& s, const VertexID& t, const LabelSet& ls) const;
+        bool searchFallback(const VertexID& s, const VertexID& t, const LabelSet& ls, QueryContext& c) const;
+        inline bool passUQF(const VertexID& s, const VertexID& t) const;
+        inline int reduceDegreeOne(VertexID& curS, VertexID& curT, const LabelSet& ls, QueryContext& c) const;
+        inline bool advanceQuery(InflightQuery& q, const PerQuery& pq, char& ans, QueryContext& c) const;
 };
 
 
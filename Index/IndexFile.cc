@@ -0,0 +1,93 @@
+/*
+LCR - Index File
+Author: Yuzheng Cai
+2022-10-27
+------------------------------
+C++ 11
+Writing, checking and mapping index files
+*/
+
+#ifndef INDEXFILE_CC
+#define INDEXFILE_CC
+#include "IndexFile.h"
+
+
+inline size_t alignIndexFileOffset(const size_t& offset) {
+    return (offset+INDEX_FILE_ALIGNMENT-1) / INDEX_FILE_ALIGNMENT * INDEX_FILE_ALIGNMENT;
+}
+
+
+void writeIndexFile(const string& filename, IndexFileHeader header, const IndexFileArrays& arrays) {
+    strncpy(header.magic, INDEX_FILE_MAGIC, sizeof(header.magic));
+    header.version = INDEX_FILE_VERSION;
+    header.checksum = 0;
+    for (const auto& array : arrays)
+        header.checksum = checksum64(*array.first, array.second, header.checksum);
+
+    string tmpFilename = filename+".tmp";
+    ofstream outputFile(tmpFilename, ios::binary);
+    outputFile.write((const char*)&header, sizeof(header));
+    size_t offset = sizeof(header);
+    const char padding[INDEX_FILE_ALIGNMENT] = {0};
+    for (const auto& array : arrays) {
+        outputFile.write(padding, alignIndexFileOffset(offset)-offset);
+        outputFile.write(*array.first, array.second);
+        offset = alignIndexFileOffset(offset) + array.second;
+    }
+    outputFile.close();
+    if (!outputFile || rename(tmpFilename.c_str(), filename.c_str())!=0) {
+        cerr<<"! Error! Cannot write "<<filename<<endl;
+        exit(-1);
+    }
+}
+
+
+bool readIndexFileHeader(const string& filename, IndexFileHeader& header) {
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd<0)
+        return false;
+    bool valid = pread(fd, &header, sizeof(header), 0)==sizeof(header) && strncmp(header.magic, INDEX_FILE_MAGIC, sizeof(header.magic))==0 && header.version==INDEX_FILE_VERSION;
+    close(fd);
+    return valid;
+}
+
+
+void* mapIndexFile(const string& filename, const IndexFileHeader& header, const IndexFileArrays& arrays, size_t& mappedSize) {
+    size_t expectedSize = sizeof(header);
+    for (const auto& array : arrays)
+        expectedSize = alignIndexFileOffset(expectedSize) + array.second;
+
+    int fd = open(filename.c_str(), O_RDONLY);
+    struct stat fileStat;
+    if (fd<0 || fstat(fd, &fileStat)!=0 || size_t(fileStat.st_size)!=expectedSize) {
+        if (fd>=0)
+            close(fd);
+        return NULL;
+    }
+
+    // pages are shared by all processes reading the same file
+    mappedSize = fileStat.st_size;
+    void* mappedFile = mmap(NULL, mappedSize, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mappedFile==MAP_FAILED)
+        return NULL;
+
+    size_t offset = sizeof(header);
+    unsigned long long checksum = 0;
+    for (const auto& array : arrays) {
+        offset = alignIndexFileOffset(offset);
+        *array.first = (char*)mappedFile + offset;
+        checksum = checksum64(*array.first, array.second, checksum);
+        offset += array.second;
+    }
+    if (checksum!=header.checksum) {
+        munmap(mappedFile, mappedSize);
+        for (const auto& array : arrays)
+            *array.first = NULL;
+        return NULL;
+    }
+    return mappedFile;
+}
+
+
+#endif
@@ -0,0 +1,54 @@
+/*
+LCR - Index File
+Author: Yuzheng Cai
+2022-10-27
+------------------------------
+C++ 11
+Built index saved in a binary file, which is mapped into memory when loaded, so that processes answering
+queries on the same host share one copy of the index in page cache
+*/
+
+#ifndef INDEXFILE_H
+#define INDEXFILE_H
+#include "../GraphUtils/Utils.h"
+
+
+// header of index file, followed by arrays of the index (see HopIndex::getFileArrays()), each starting
+// at a multiple of INDEX_FILE_ALIGNMENT bytes
+#define INDEX_FILE_MAGIC "LCRIDX"
+#define INDEX_FILE_VERSION 4
+#define INDEX_FILE_ALIGNMENT 64
+struct IndexFileHeader {
+    char magic[8];
+    unsigned int version;
+    unsigned int largeLabelSet;                     // 0 for Index, 1 for IndexL
+    VertexID VN, DAGVN;
+    EdgeID adjEN;
+    LabelID labelNum;
+    unsigned long long graphChecksum;               // checksum of the graph that index is built on
+    unsigned int compressed, labelWidth;            // whether hop lists are compressed, and bits per label set
+    unsigned long long inHopSize, outHopSize;       // entries of packed hop lists, or bytes of compressed ones
+    unsigned long long inEntryNum, outEntryNum;     // entries of hop lists
+    unsigned long long hopRankingChecksum;          // checksum of the hop order that index is built with
+    LabelSet primaryMask;                           // for IndexL
+    unsigned int labelBudget;                       // maximum number of labels of entries, 0 for no limit
+    unsigned int restricted;                        // whether only ends of DOR chains of terminals keep hop lists
+    unsigned long long checksum;                    // checksum of all arrays
+};
+
+
+// arrays stored in index file in order, i.e., pointer to array and its size in bytes
+typedef vector<pair<char**, size_t>> IndexFileArrays;
+
+// write header and arrays to filename+".tmp", then rename it to filename, so that processes mapping
+// the old file are not affected
+void writeIndexFile(const string& filename, IndexFileHeader header, const IndexFileArrays& arrays);
+
+// read the header, return false if the file does not exist, or it is not an index file of current version
+bool readIndexFileHeader(const string& filename, IndexFileHeader& header);
+
+// map the file into memory and point arrays into it, return NULL if the file is truncated or corrupted
+void* mapIndexFile(const string& filename, const IndexFileHeader& header, const IndexFileArrays& arrays, size_t& mappedSize);
+
+
+#endif
@@ -10,63 +10,35 @@ Implementations for graphs with large number of labels
 
 #ifndef INDEXL_H
 #define INDEXL_H
-#include "../GraphUtils/Graph.cc"
-#include "GenerateDAG.cc"
-#include "UQF.cc"
+#include "HopIndex.cc"
 
 
-class IndexL {
+class IndexL : public HopIndex<IndexL> {
+    friend class HopIndex<IndexL>;
+
     public:
         IndexL(Graph* graph);
 
-        // build and free index
-        double buildIndex();
+        // free index with the label mapping
         void freeIndex();
 
-        // answering queries
-        bool query(const VertexID& s, const VertexID& t, const vector<LabelID>& ls);
-        double runAllQueries(const vector<PerQuery>& queries);
-        
-        // stats
-        double getIndexSizeInBytes();
-        double getIndexEntryCnt();
+        // answering queries, the built index is never modified, so that threads with their own contexts can query concurrently
+        bool query(const VertexID& s, const VertexID& t, const vector<LabelID>& ls, QueryContext* ctx=NULL) const;
 
     private:
 
-        // basic graph information
-        Graph* graph;
-        VertexID VN, DAGVN;
-        EdgeID EN;
-        LabelID labelNum;
-        PerNeighbor* neighbors;  
-        
         // divide secondary labels
         void divideLabels();
         LabelSet primaryMask = 0;
         vector<LabelID> labelMapping;
         vector<LabelID>* reverseMapping;
+        inline LabelSet labelBit(const LabelID& label) const { return 1<<labelMapping[label]; }     // virtual label of an edge
+        void saveLabelMapping(IndexFileHeader& header, LabelID*& mapping);     // label mapping kept in index file
+        void loadLabelMapping(const IndexFileHeader& header, const LabelID* mapping);
 
-        // build 2-hop index with degree-one reduction (DOR)
-        bool builtIndex = false;
-        vector<pair<VertexID, LabelSet>> frontier, nxtFrontier;
-        bool* isProcessed;
-        int *visited, offset=1;
-        void exploreForwardWithCurLabels(const VertexID& hopId, const VertexID& order);
-        void exploreForwardPlusOneLabel(const VertexID& hopId, const VertexID& order);
-        void exploreBackwardWithCurLabels(const VertexID& hopId, const VertexID& order);
-        void exploreBackwardPlusOneLabel(const VertexID& hopId, const VertexID& order);
-        inline bool queryForIndexForward(const VertexID& order, const VertexID& hopId, const VertexID& v, const LabelSet& ls);
-        inline bool queryForIndexBackward(const VertexID& order, const VertexID& v, const VertexID& hopId, const LabelSet& ls);
-        void build2hop();
-
-        // for online query
-        IndexNode* index;                          
-        UQFindexNode* UQForders;
-        bool query2hop(const VertexID& s, const VertexID& t, const LabelSet& ls);
-
-        // for online search
-        int *visitedS, offsetS=0;
-        VertexID *Q, queueBegin=0, queueEnd=0;
+        // neighbors of u in runs of ids sharing labels, i.e., f(begin, end, labels) for each run, for pruned BFS
+        template<typename F> inline void forEachInRun(const VertexID& u, F f) const;
+        template<typename F> inline void forEachOutRun(const VertexID& u, F f) const;
 };
 
 
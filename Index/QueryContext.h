@@ -0,0 +1,56 @@
+/*
+LCR - Query Context
+Author: Yuzheng Cai
+2022-10-27
+------------------------------
+C++ 11 
+Scratch state of answering queries, so that a built index can be queried by several threads
+*/ 
+
+#ifndef QUERYCONTEXT_H
+#define QUERYCONTEXT_H
+#include "../GraphUtils/Graph.cc"
+
+
+// each thread owns its own context
+struct QueryContext {
+    VertexID VN;
+    int *visited, offset = 0;                       // vertices on degree-one chains of s and t
+    int *visitedS, offsetS = 0;                     // fallback BFS of IndexL
+    VertexID *Q;
+    SearchContext* search = NULL;                   // online search on the graph, allocated when first used
+
+    QueryContext(const VertexID& n) {
+        VN = n;
+        visited = new int[VN]();
+        visitedS = new int[VN]();
+        Q = new VertexID[VN];
+    }
+
+    ~QueryContext() {
+        delete[] visited;
+        delete[] visitedS;
+        delete[] Q;
+        if (search)
+            delete search;
+    }
+
+    // new marks for visited and visitedS, all marks are cleared when they wrap around
+    inline int nextMark() {
+        if (offset >= INT_MAX-1) {
+            offset = 0;
+            memset(visited, 0, sizeof(int)*VN);
+        }
+        return ++offset;
+    }
+    inline int nextMarkS() {
+        if (offsetS >= INT_MAX-1) {
+            offsetS = 0;
+            memset(visitedS, 0, sizeof(int)*VN);
+        }
+        return ++offsetS;
+    }
+};
+
+
+#endif
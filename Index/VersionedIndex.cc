@@ -0,0 +1,279 @@
+/*
+LCR - Versioned Index
+Author: Yuzheng Cai
+2022-10-27
+------------------------------
+C++ 11
+Background rebuilding, publishing and reclamation of index versions
+*/
+
+#ifndef VERSIONEDINDEX_CC
+#define VERSIONEDINDEX_CC
+#include "VersionedIndex.h"
+
+
+template<typename IndexType>
+VersionedIndex<IndexType>::VersionedIndex(Graph* graph, IndexType* index) {
+    current = new IndexVersion<IndexType>{0, graph, index};
+    globalEpoch = 1;
+    readerCnt = 0;
+    rebuilding = false;
+    for (unsigned int i=0; i<MAX_INDEX_READERS; ++i) {
+        readers[i].epoch = 0;
+        readers[i].ctx = NULL;
+        readers[i].versionId = 0;
+    }
+}
+
+
+template<typename IndexType>
+VersionedIndex<IndexType>::~VersionedIndex() {
+    waitRebuild();
+    for (unsigned int i=0; i<readerCnt; ++i)
+        delete readers[i].ctx;
+    freeVersion(current.load());
+}
+
+
+template<typename IndexType>
+void VersionedIndex<IndexType>::freeVersion(IndexVersion<IndexType>* version) {
+    version->index->freeIndex();
+    delete version->index;
+    delete version->graph;
+    delete version;
+}
+
+
+// all versions have the same vertices, so that the context of a reader is used for every version
+template<typename IndexType>
+unsigned int VersionedIndex<IndexType>::registerReader() {
+    unsigned int reader = readerCnt++;
+    if (reader>=MAX_INDEX_READERS) {
+        cerr<<"! Error! More than "<<MAX_INDEX_READERS<<" readers are registered to the versioned index!"<<endl;
+        exit(-1);
+    }
+    readers[reader].ctx = current.load()->index->newQueryContext();
+    return reader;
+}
+
+
+// the version loaded after announcing the epoch is not freed until the slot is cleared
+template<typename IndexType>
+template<typename Labels>
+bool VersionedIndex<IndexType>::query(const unsigned int& reader, const VertexID& s, const VertexID& t, const Labels& ls) {
+    ReaderSlot& slot = readers[reader];
+    slot.epoch.store(globalEpoch.load());
+    IndexVersion<IndexType>* version = current.load();
+    bool ans = version->index->query(s, t, ls, slot.ctx);
+    slot.versionId = version->id;
+    slot.epoch.store(0, memory_order_release);
+    return ans;
+}
+
+
+template<typename IndexType>
+bool VersionedIndex<IndexType>::insertEdge(const VertexID& s, const VertexID& t, const LabelID& label) {
+    const Graph* graph = current.load()->graph;
+    if (s>=graph->VN || t>=graph->VN || label>=graph->labelNum || s==t)
+        return false;
+    lock_guard<mutex> lock(pendingMutex);
+    pendingEdges.emplace_back(s, t, label);
+    return true;
+}
+
+
+template<typename IndexType>
+bool VersionedIndex<IndexType>::startRebuild() {
+    if (rebuilding.exchange(true))
+        return false;
+    if (rebuildThread.joinable())
+        rebuildThread.join();
+    rebuildThread = thread(&VersionedIndex<IndexType>::rebuild, this);
+    return true;
+}
+
+
+template<typename IndexType>
+void VersionedIndex<IndexType>::waitRebuild() {
+    if (rebuildThread.joinable())
+        rebuildThread.join();
+}
+
+
+// wait until no reader holds a version loaded before the epoch is advanced
+template<typename IndexType>
+void VersionedIndex<IndexType>::synchronize() {
+    unsigned long long epoch = ++globalEpoch;
+    unsigned int n = readerCnt;
+    for (unsigned int i=0; i<n; ++i)
+        while (true) {
+            unsigned long long e = readers[i].epoch.load();
+            if (e==0 || e>=epoch)
+                break;
+            this_thread::yield();
+        }
+}
+
+
+// only the rebuild thread replaces versions, so the current version stays alive while it is snapshotted
+template<typename IndexType>
+void VersionedIndex<IndexType>::rebuild() {
+    IndexVersion<IndexType>* old = current.load();
+    const unsigned int oldId = old->id;
+    vector<PerEdge> edges;
+    {
+        lock_guard<mutex> lock(pendingMutex);
+        edges.swap(pendingEdges);
+    }
+
+    double startTime = getWallTimeInMs();
+    printf("Start rebuilding version %u with %d inserted edges in background ...\n", oldId+1, int(edges.size()));
+    Graph* graph = new Graph(*(old->graph), edges);
+    IndexType* index = new IndexType(graph);
+    index->buildIndex();
+    current.store(new IndexVersion<IndexType>{oldId+1, graph, index});
+    lastRebuildTime = getWallTimeInMs()-startTime;
+
+    // free the old version after readers using it finish
+    startTime = getWallTimeInMs();
+    synchronize();
+    lastGraceTime = getWallTimeInMs()-startTime;
+    freeVersion(old);
+    releaseFreeHeapMemory();
+    printf("- Published version %u, rebuilding: %.2fms, grace period before freeing version %u: %.3fms\n", oldId+1, lastRebuildTime, oldId, lastGraceTime);
+    rebuilding = false;
+}
+
+
+// latencies are counted in buckets of 1/8 octave, i.e., about 12% precision
+#define LATENCY_BUCKETS 512
+struct LatencyHistogram {
+    vector<unsigned long long> buckets = vector<unsigned long long>(LATENCY_BUCKETS, 0);
+    unsigned long long cnt = 0, maxNs = 0;
+
+    inline void add(const unsigned long long& ns) {
+        ++cnt;
+        maxNs = max(maxNs, ns);
+        if (ns<8)
+            ++buckets[ns];
+        else {
+            int octave = 63-__builtin_clzll(ns);
+            ++buckets[octave*8 + ((ns>>(octave-3))&7)];
+        }
+    }
+    void merge(const LatencyHistogram& other) {
+        for (int b=0; b<LATENCY_BUCKETS; ++b)
+            buckets[b] += other.buckets[b];
+        cnt += other.cnt;
+        maxNs = max(maxNs, other.maxNs);
+    }
+
+    // upper bound of the bucket containing the p-quantile, in microseconds
+    double percentile(const double& p) const {
+        unsigned long long rank = (unsigned long long)(p*cnt), seen = 0;
+        for (int b=0; b<LATENCY_BUCKETS; ++b) {
+            seen += buckets[b];
+            if (seen>rank) {
+                if (b<8)
+                    return (b+1)/1000.0;
+                int octave = b/8;
+                return (double)((unsigned long long)(8+b%8+1)<<(octave-3))/1000.0;
+            }
+        }
+        return maxNs/1000.0;
+    }
+};
+
+
+template<typename IndexType>
+void VersionedIndex<IndexType>::runBackgroundRebuild(const vector<PerQuery>& queries, const vector<PerEdge>& edges) {
+    if (queries.empty()) {
+        cout << "! No queries for measuring latency during rebuilding" <<endl;
+        return;
+    }
+    unsigned int num = getThreadNum();
+    printf("Start answering %d queries repeatedly by %u threads, and rebuilding the index in background after inserting %d edges ...\n", int(queries.size()), num, int(edges.size()));
+
+    // phase 0: old version only, phase 1: rebuilding, phase 2: after publishing the new version, 3: stop
+    const char* phaseNames[3] = {"before rebuilding", "during rebuilding", "after publishing"};
+    atomic<int> phase(0);
+    atomic<unsigned long long> answeredCnt(0);
+    vector<vector<LatencyHistogram>> histograms(num, vector<LatencyHistogram>(3));
+    vector<int> wrongCnt(num, 0);
+    vector<thread> threads;
+    for (unsigned int tid=0; tid<num; ++tid)
+        threads.emplace_back([&, tid]() {
+            unsigned int reader = registerReader();
+            for (size_t i=tid; ; i+=num) {
+                int p = phase.load(memory_order_relaxed);
+                if (p==3)
+                    break;
+                const PerQuery& q = queries[i%queries.size()];
+                auto start = chrono::steady_clock::now();
+                bool ans = query(reader, q.s, q.t, getQueryLabels(q, (IndexType*)NULL));
+                auto end = chrono::steady_clock::now();
+                histograms[tid][p].add(chrono::duration_cast<chrono::nanoseconds>(end-start).count());
+                if (readers[reader].versionId==0 && ans!=q.ans)
+                    ++wrongCnt[tid];
+                answeredCnt.fetch_add(1, memory_order_relaxed);
+            }
+        });
+
+    // each phase without rebuilding lasts until all queries are answered once
+    auto waitForQueries = [&]() {
+        unsigned long long target = answeredCnt+queries.size();
+        while (answeredCnt<target)
+            this_thread::sleep_for(chrono::milliseconds(1));
+    };
+    double phaseTime[3];
+    double startTime = getWallTimeInMs();
+    waitForQueries();
+    phaseTime[0] = getWallTimeInMs()-startTime;
+
+    startTime = getWallTimeInMs();
+    phase = 1;
+    for (const PerEdge& e : edges)
+        insertEdge(e.src, e.dst, e.label);
+    startRebuild();
+    waitRebuild();
+    phaseTime[1] = getWallTimeInMs()-startTime;
+
+    startTime = getWallTimeInMs();
+    phase = 2;
+    waitForQueries();
+    phaseTime[2] = getWallTimeInMs()-startTime;
+    phase = 3;
+    for (thread& t : threads)
+        t.join();
+
+    // readers never wait for the rebuild, so the max latency bounds the downtime
+    for (int p=0; p<3; ++p) {
+        LatencyHistogram all;
+        for (unsigned int tid=0; tid<num; ++tid)
+            all.merge(histograms[tid][p]);
+        printf("- Queries %s: %llu, throughput: %.0f queries/s, latency p50: %.3fus, p99: %.3fus, p99.9: %.3fus, max: %.3fus\n", phaseNames[p],
+               all.cnt, all.cnt/max(phaseTime[p], 1e-3)*1000, all.percentile(0.5), all.percentile(0.99), all.percentile(0.999), all.maxNs/1000.0);
+    }
+    int wrongTotal = 0;
+    for (unsigned int tid=0; tid<num; ++tid)
+        wrongTotal += wrongCnt[tid];
+    printf("- Wrong answers of version 0: %d\n", wrongTotal);
+
+    // answers of the new version are checked against multi-source BFS on its graph
+    IndexVersion<IndexType>* version = current.load();
+    vector<bool> answers;
+    SearchContext* searchCtx = version->graph->newSearchContext();
+    version->graph->LCRsearchBatch(queries, isLargeLabelSet(version->index), answers, searchCtx);
+    delete searchCtx;
+    int newWrongCnt = 0, changedCnt = 0;
+    unsigned int reader = 0;
+    for (size_t i=0; i<queries.size(); ++i) {
+        const PerQuery& q = queries[i];
+        newWrongCnt += query(reader, q.s, q.t, getQueryLabels(q, version->index))!=answers[i];
+        changedCnt += answers[i]!=q.ans;
+    }
+    printf("- Verified version %u by multi-source BFS, wrong answers: %d, answers changed by inserted edges: %d\n", version->id, newWrongCnt, changedCnt);
+}
+
+
+#endif
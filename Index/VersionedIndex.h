@@ -0,0 +1,88 @@
+/*
+LCR - Versioned Index
+Author: Yuzheng Cai
+2022-10-27
+------------------------------
+C++ 11
+Index versions rebuilt on a background thread while the current version keeps answering queries, a new
+version is published by an atomic pointer swap, and the old one is freed after readers using it finish
+*/
+
+#ifndef VERSIONEDINDEX_H
+#define VERSIONEDINDEX_H
+#include "Index.cc"
+#include "IndexL.cc"
+
+
+// maximum number of reader threads registered to a versioned index
+#define MAX_INDEX_READERS 256
+
+
+// a built index together with the graph it is built on, both owned by the version
+template<typename IndexType>
+struct IndexVersion {
+    unsigned int id;
+    Graph* graph;
+    IndexType* index;
+};
+
+
+/*
+ * epoch-based reclamation of index versions
+ *   a reader announces the global epoch in its slot before loading the current version, and clears the slot (0)
+ *   after its query, so readers never wait for writers
+ *   the writer swaps in the new version, advances the global epoch to E, and waits until every slot is either
+ *   idle or announces an epoch no smaller than E, after which no reader can still hold the old version
+ */
+template<typename IndexType>
+class VersionedIndex {
+    public:
+        // take over the graph and the built index as the first version
+        VersionedIndex(Graph* graph, IndexType* index);
+        ~VersionedIndex();
+
+        // each thread answering queries registers once, and passes its reader id to query()
+        unsigned int registerReader();
+        template<typename Labels>
+        bool query(const unsigned int& reader, const VertexID& s, const VertexID& t, const Labels& ls);
+
+        // insert edge (s, t, label) into the next version, return false if the edge is invalid
+        bool insertEdge(const VertexID& s, const VertexID& t, const LabelID& label);
+
+        // build a new version from a snapshot of current graph with inserted edges on a background thread,
+        // return false if a rebuild is already running
+        bool startRebuild();
+        void waitRebuild();
+
+        // answer queries repeatedly by reader threads before, during and after rebuilding with edges inserted,
+        // and print latency percentiles of each phase
+        void runBackgroundRebuild(const vector<PerQuery>& queries, const vector<PerEdge>& edges);
+
+    private:
+        atomic<IndexVersion<IndexType>*> current;
+        atomic<unsigned long long> globalEpoch;
+
+        // each slot occupies its own cache line, avoiding false sharing between readers
+        struct ReaderSlot {
+            atomic<unsigned long long> epoch;
+            QueryContext* ctx;
+            unsigned int versionId;                     // version answering the last query
+            char padding[64];
+        };
+        ReaderSlot readers[MAX_INDEX_READERS];
+        atomic<unsigned int> readerCnt;
+
+        // edges inserted after the last snapshot, and the rebuild thread
+        mutex pendingMutex;
+        vector<PerEdge> pendingEdges;
+        thread rebuildThread;
+        atomic<bool> rebuilding;
+        double lastRebuildTime = 0, lastGraceTime = 0;
+
+        void rebuild();
+        void synchronize();
+        void freeVersion(IndexVersion<IndexType>* version);
+};
+
+
+#endif
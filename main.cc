@@ -9,26 +9,99 @@ C++ 11
 
 #include "Index/Index.cc"
 #include "Index/IndexL.cc"
+#include "Index/VersionedIndex.cc"
 
 
 int main(int argc, char* argv[]) {
 
     // parameters
     if (argc<2) {
-        printf("Usage: ./%s <graphFilename>\n", argv[0]);
+        printf("Usage: ./%s <graphFilename> [-collapse] [-reorder rcm|degree|hop] [-bidirectional]"
+               " [-verify]"
+               " [-direction-optimizing]"
+               " [-parallel] [-threads <num>]"
+               " [-interleave]"
+               " [-compress]"
+               " [-index-file <file>]"
+               " [-insert-edges <file>]"
+               " [-background-rebuild]"
+               " [-hop-order degree|product|label-degree|betweenness|scc] [-hop-order-file <file>]"
+               " [-frontier-dedup]"
+               " [-remove-redundant]"
+               " [-label-budget <num>]"
+               " [-terminals <file>]"
+               "\n", argv[0]);
         exit(-1);
     } 
     graphFilename = datasetPath+argv[1];
+
+    // options
+    for (int i=2; i<argc; ++i) {
+        string option = argv[i];
+        if (option=="-collapse")
+            collapseParallelEdges = true;
+        else if (option=="-reorder" && i+1<argc)
+            reorderStrategy = argv[++i];
+        else if (option=="-bidirectional")
+            bidirectionalSearch = true;
+        else if (option=="-direction-optimizing")
+            directionOptimizing = true;
+        else if (option=="-parallel")
+            parallelQueries = true;
+        else if (option=="-interleave")
+            interleavedQueries = true;
+        else if (option=="-threads" && i+1<argc)
+            threadNum = atoi(argv[++i]);
+        else if (option=="-verify")
+            verifyQueries = true;
+        else if (option=="-compress")
+            compressIndex = true;
+        else if (option=="-hop-order" && i+1<argc)
+            hopOrderStrategy = argv[++i];
+        else if (option=="-hop-order-file" && i+1<argc) {
+            hopOrderStrategy = "file";
+            hopOrderFilename = argv[++i];
+        }
+        else if (option=="-frontier-dedup")
+            dedupFrontiers = true;
+        else if (option=="-label-budget" && i+1<argc)
+            labelBudget = atoi(argv[++i]);
+        else if (option=="-terminals" && i+1<argc)
+            terminalFilename = argv[++i];
+        else if (option=="-remove-redundant")
+            removeRedundant = true;
+        else if (option=="-index-file" && i+1<argc)
+            indexFilename = argv[++i];
+        else if (option=="-insert-edges" && i+1<argc)
+            insertEdgesFilename = argv[++i];
+        else if (option=="-background-rebuild")
+            backgroundRebuild = true;
+        else {
+            printf("! Unknown option %s\n", argv[i]);
+            exit(-1);
+        }
+    }
     
     // read in graph
     Graph* graph = new Graph(graphFilename);
 
+    // binary graph "xxx.edge.bin" shares query files with its txt graph "xxx.edge"
+    string queryFilePrefix = graphFilename;
+    if (queryFilePrefix.size()>4 && queryFilePrefix.compare(queryFilePrefix.size()-4, 4, ".bin")==0)
+        queryFilePrefix.resize(queryFilePrefix.size()-4);
+
     // for graphs with small number of labels
     if (graph->labelNum <= 2*THRESHOLD) {
         Index* index = new Index(graph);
 
-        // build index with pruning techniques 
-        double indexTime = index->buildIndex();
+        // load index from file, or build index with pruning techniques 
+        double indexTime = indexFilename=="" ? -1 : index->loadIndex(indexFilename);
+        double buildTime = -1;
+        if (indexTime<0) {
+            indexTime = buildTime = index->buildIndex();
+            if (indexFilename!="")
+                index->saveIndex(indexFilename);
+        }
         double indexSize = index->getIndexSizeInBytes();
         double indexEntryCnt = index->getIndexEntryCnt();
 
@@ -36,28 +109,48 @@ int main(int argc, char* argv[]) {
         logFile<<graphFilename<<","<<(graph->VN)<<","<<(graph->EN)<<","<<(graph->labelNum)<<","<<indexTime<<","<<indexEntryCnt<<","<<indexSize;
 
         // for each query file 
+        vector<PerQuery> allQueries;
         for (int k=0; k<3; ++k) {
             
             // load all queries
-            vector<PerQuery> queries = loadQueryFile(graphFilename+"-"+to_string(k)+".query", false);
+            vector<PerQuery> queries = loadQueryFile(queryFilePrefix+"-"+to_string(k)+".query", false);
 
             // run all queries
             double queryTime = index->runAllQueries(queries)*1000;
 
             // write to log file
             logFile<<","<<queries.size()<<","<<queryTime;
+            if (insertEdgesFilename!="")
+                allQueries.insert(allQueries.end(), queries.begin(), queries.end());
+        }
+
+        // insert edges into a new version rebuilt in background, the versioned index takes over graph and index
+        if (insertEdgesFilename!="" && backgroundRebuild) {
+            VersionedIndex<Index>* versions = new VersionedIndex<Index>(graph, index);
+            versions->runBackgroundRebuild(allQueries, loadEdgeFile(insertEdgesFilename));
+            delete versions;
+            graph = NULL;
+
+        // insert edges incrementally, compared with rebuilding the index
+        } else {
+            if (insertEdgesFilename!="")
+                index->runEdgeInsertions(loadEdgeFile(insertEdgesFilename), buildTime, allQueries);
+            index->freeIndex();
+            delete index;
         }
-        
-        // clean up
-        index->freeIndex();
-        delete index;
 
     // for graphs with large number of labels
     } else {
         IndexL* index = new IndexL(graph);
 
-        // build index with pruning techniques 
-        double indexTime = index->buildIndex();
+        // load index from file, or build index with pruning techniques 
+        double indexTime = indexFilename=="" ? -1 : index->loadIndex(indexFilename);
+        double buildTime = -1;
+        if (indexTime<0) {
+            indexTime = buildTime = index->buildIndex();
+            if (indexFilename!="")
+                index->saveIndex(indexFilename);
+        }
         double indexSize = index->getIndexSizeInBytes();
         double indexEntryCnt = index->getIndexEntryCnt();
 
@@ -65,21 +158,35 @@ int main(int argc, char* argv[]) {
         logFile<<graphFilename<<","<<(graph->VN)<<","<<(graph->EN)<<","<<(graph->labelNum)<<","<<indexTime<<","<<indexEntryCnt<<","<<indexSize;
 
         // for each query file 
+        vector<PerQuery> allQueries;
         for (int k=0; k<3; ++k) {
             
             // load all queries
-            vector<PerQuery> queries = loadQueryFile(graphFilename+"-"+to_string(k)+".query", true);
+            vector<PerQuery> queries = loadQueryFile(queryFilePrefix+"-"+to_string(k)+".query", true);
 
             // run all queries
             double queryTime = index->runAllQueries(queries)*1000;
 
             // write to log file
             logFile<<","<<queries.size()<<","<<queryTime;
+            if (insertEdgesFilename!="")
+                allQueries.insert(allQueries.end(), queries.begin(), queries.end());
+        }
+
+        // insert edges into a new version rebuilt in background, the versioned index takes over graph and index
+        if (insertEdgesFilename!="" && backgroundRebuild) {
+            VersionedIndex<IndexL>* versions = new VersionedIndex<IndexL>(graph, index);
+            versions->runBackgroundRebuild(allQueries, loadEdgeFile(insertEdgesFilename));
+            delete versions;
+            graph = NULL;
+
+        // insert edges incrementally, compared with rebuilding the index
+        } else {
+            if (insertEdgesFilename!="")
+                index->runEdgeInsertions(loadEdgeFile(insertEdgesFilename), buildTime, allQueries);
+            index->freeIndex();
+            delete index;
         }
-        
-        // clean up
-        index->freeIndex();
-        delete index;
     }
     
     // clean up